@@ -0,0 +1,174 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <condition_variable>
+
+#include "async_file_writer.h"
+
+namespace luisa {
+
+struct AsyncFileWriter::State {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::ofstream file;
+    // queued buffers; the front one is being written while `scheduled` is set
+    std::deque<Buffer> pending;
+    std::vector<Buffer> free;
+    size_t max_pending{0u};
+    // whether an I/O thread owns the file
+    bool scheduled{false};
+    bool failed{false};
+};
+
+namespace {
+
+// The I/O threads. Each file is drained by at most one thread at a time, so
+// its buffers are written in order; different files are written in parallel.
+class IoThreads {
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<std::shared_ptr<AsyncFileWriter::State>> _ready;
+    std::vector<std::thread> _threads;
+    bool _stop{false};
+
+private:
+    static void _drain(AsyncFileWriter::State &s) noexcept {
+        std::unique_lock lock{s.mutex};
+        while (!s.pending.empty()) {
+            // references to deque elements stay valid while others are pushed back
+            auto &buffer = s.pending.front();
+            auto skip = s.failed;
+            lock.unlock();
+            if (!skip) { s.file.write(buffer.data(), static_cast<std::streamsize>(buffer.size())); }
+            auto good = s.file.good();
+            lock.lock();
+            s.failed |= !good;
+            if (s.free.size() < s.max_pending) {
+                buffer.clear();
+                s.free.emplace_back(std::move(buffer));
+            }
+            s.pending.pop_front();
+            s.cv.notify_all();
+        }
+        s.scheduled = false;
+        s.cv.notify_all();
+    }
+
+    void _run() noexcept {
+        for (;;) {
+            std::shared_ptr<AsyncFileWriter::State> state;
+            {
+                std::unique_lock lock{_mutex};
+                _cv.wait(lock, [this] { return _stop || !_ready.empty(); });
+                if (_ready.empty()) { return; }
+                state = std::move(_ready.front());
+                _ready.pop_front();
+            }
+            _drain(*state);
+        }
+    }
+
+public:
+    IoThreads() noexcept {
+        // a few threads suffice to keep the disks busy
+        auto n = std::clamp(std::thread::hardware_concurrency() / 4u, 1u, 4u);
+        for (auto i = 0u; i < n; i++) { _threads.emplace_back([this] { _run(); }); }
+    }
+    ~IoThreads() noexcept {
+        {
+            std::scoped_lock lock{_mutex};
+            _stop = true;
+        }
+        _cv.notify_all();
+        for (auto &&t : _threads) { t.join(); }
+    }
+    [[nodiscard]] static IoThreads &instance() noexcept {
+        static IoThreads threads;
+        return threads;
+    }
+    void schedule(std::shared_ptr<AsyncFileWriter::State> state) noexcept {
+        {
+            std::scoped_lock lock{_mutex};
+            _ready.emplace_back(std::move(state));
+        }
+        _cv.notify_one();
+    }
+};
+
+// waits until no buffer is queued and no I/O thread owns the file
+void wait_idle(AsyncFileWriter::State &s, std::unique_lock<std::mutex> &lock) noexcept {
+    s.cv.wait(lock, [&s] { return s.pending.empty() && !s.scheduled; });
+}
+
+}// namespace
+
+AsyncFileWriter::AsyncFileWriter(const std::filesystem::path &path, size_t max_pending) noexcept
+    : _state{std::make_shared<State>()} {
+    _state->file.open(path, std::ios::binary);
+    _open = _state->file.is_open();
+    _state->max_pending = std::max<size_t>(max_pending, 1u);
+}
+
+AsyncFileWriter::~AsyncFileWriter() noexcept {
+    if (is_open()) { static_cast<void>(close()); }
+}
+
+AsyncFileWriter::Buffer AsyncFileWriter::submit(Buffer buffer) {
+    auto capacity = buffer.capacity();
+    Buffer next;
+    if (!buffer.empty()) {
+        std::unique_lock lock{_state->mutex};
+        _state->cv.wait(lock, [this] { return _state->pending.size() < _state->max_pending; });
+        _state->pending.emplace_back(std::move(buffer));
+        if (!_state->scheduled) {
+            _state->scheduled = true;
+            IoThreads::instance().schedule(_state);
+        }
+        if (!_state->free.empty()) {
+            next = std::move(_state->free.back());
+            _state->free.pop_back();
+        }
+    } else {
+        next = std::move(buffer);
+    }
+    next.reserve(capacity);
+    return next;
+}
+
+void AsyncFileWriter::write(const void *data, size_t size) {
+    constexpr auto chunk_size = 4u * 1024u * 1024u;
+    auto p = static_cast<const char *>(data);
+    Buffer buffer;
+    for (auto offset = size_t{0u}; offset < size; offset += chunk_size) {
+        buffer.assign(p + offset, std::min<size_t>(chunk_size, size - offset));
+        buffer = submit(std::move(buffer));
+    }
+}
+
+void AsyncFileWriter::overwrite(uint64_t offset, const void *data, size_t size) {
+    std::unique_lock lock{_state->mutex};
+    wait_idle(*_state, lock);
+    _state->file.seekp(static_cast<std::streamoff>(offset));
+    _state->file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    _state->file.seekp(0, std::ios::end);
+    _state->failed |= !_state->file.good();
+}
+
+bool AsyncFileWriter::close() noexcept {
+    std::unique_lock lock{_state->mutex};
+    wait_idle(*_state, lock);
+    _open = false;
+    _state->file.close();
+    return !_state->failed && !_state->file.fail();
+}
+
+}// namespace luisa
@@ -0,0 +1,48 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <filesystem>
+
+namespace luisa {
+
+// Sequential file output whose buffers are written by a few background I/O
+// threads shared by all files, so that producing the next buffer overlaps with
+// writing the previous ones. At most `max_pending` buffers of a file are in
+// flight: submit() blocks beyond that, which bounds the memory held by slow
+// writes. Buffers are recycled between the producer and the I/O threads.
+class AsyncFileWriter {
+
+public:
+    using Buffer = std::string;
+    struct State;
+
+private:
+    std::shared_ptr<State> _state;
+    bool _open{false};
+
+public:
+    explicit AsyncFileWriter(const std::filesystem::path &path, size_t max_pending = 4u) noexcept;
+    // waits for the queued writes
+    ~AsyncFileWriter() noexcept;
+    AsyncFileWriter(AsyncFileWriter &&) noexcept = delete;
+    AsyncFileWriter(const AsyncFileWriter &) noexcept = delete;
+    // false if the file could not be opened, or once it is closed
+    [[nodiscard]] auto is_open() const noexcept { return _open; }
+    // Queues the content of `buffer` for writing and returns an empty buffer with
+    // at least the same capacity to fill next.
+    [[nodiscard]] Buffer submit(Buffer buffer);
+    // copies the data into buffers and queues them
+    void write(const void *data, size_t size);
+    // waits for the queued writes, then writes `size` bytes at `offset`, e.g. to patch a header
+    void overwrite(uint64_t offset, const void *data, size_t size);
+    // waits for the queued writes and closes the file; returns whether everything was written
+    [[nodiscard]] bool close() noexcept;
+};
+
+}// namespace luisa
@@ -0,0 +1,130 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+#include "logging.h"
+#include "thread_pool.h"
+#include "batch.h"
+
+namespace luisa::render {
+
+size_t BatchSummary::failure_count() const noexcept {
+    return std::count_if(scenes.cbegin(), scenes.cend(), [](auto &&s) noexcept { return !s.succeeded; });
+}
+
+[[nodiscard]] static bool has_world_begin(const std::filesystem::path &file) {
+    constexpr std::string_view keyword{"WorldBegin"};
+    constexpr auto chunk_size = static_cast<size_t>(1024u * 1024u);
+    std::ifstream f{file, std::ios::binary};
+    expect(f.is_open(), "Failed to open scene file {}.", file.generic_string());
+    // keep the tail of the previous chunk in case the keyword straddles two chunks
+    std::string buffer;
+    while (f) {
+        auto tail = std::min(buffer.size(), keyword.size() - 1u);
+        buffer.erase(0u, buffer.size() - tail);
+        buffer.resize(tail + chunk_size);
+        f.read(buffer.data() + tail, static_cast<std::streamsize>(chunk_size));
+        buffer.resize(tail + static_cast<size_t>(f.gcount()));
+        if (buffer.find(keyword) != std::string::npos) { return true; }
+    }
+    return false;
+}
+
+std::vector<std::filesystem::path> collect_scene_files(const std::vector<std::filesystem::path> &inputs) {
+    std::vector<std::filesystem::path> scene_files;
+    for (auto &&input : inputs) {
+        if (!std::filesystem::is_directory(input)) {
+            scene_files.emplace_back(input);
+            continue;
+        }
+        std::vector<std::filesystem::path> found;
+        for (auto &&entry : std::filesystem::recursive_directory_iterator{input}) {
+            if (entry.is_regular_file() && entry.path().extension() == ".pbrt" &&
+                has_world_begin(entry.path())) {
+                found.emplace_back(entry.path());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        if (found.empty()) { eprintln("No scene files found in directory {}.", input.generic_string()); }
+        scene_files.insert(scene_files.end(), found.cbegin(), found.cend());
+    }
+    return scene_files;
+}
+
+BatchSummary convert_batch(const std::vector<std::filesystem::path> &scene_files,
+                           const ConvertOptions &options) noexcept {
+    auto start = std::chrono::steady_clock::now();
+    BatchSummary summary;
+    summary.scenes.resize(scene_files.size());
+    auto scene_options = options;
+    scene_options.profile = false;
+    scene_options.profile_report.clear();
+    ThreadPool pool{options.jobs};
+    println("Converting {} scenes with {} threads.", scene_files.size(), pool.size());
+    {
+        // The scenes run as tasks of the pool that also exports their meshes. A scene
+        // waiting for its meshes runs only tasks of its own, never another scene, so
+        // at most one scene is in flight per worker, plus one on this thread.
+        TaskGroup scenes{pool};
+        for (auto i = 0u; i < scene_files.size(); i++) {
+            scenes.dispatch([&scene_files, &summary, &scene_options, &pool, i] {
+                auto &result = summary.scenes[i];
+                result.scene_file = scene_files[i];
+                auto scene_start = std::chrono::steady_clock::now();
+                try {
+                    convert(result.scene_file.generic_string().c_str(), scene_options, pool);
+                    result.succeeded = true;
+                } catch (const std::exception &e) {
+                    result.error = e.what();
+                    eprintln("Failed to convert scene {}: {}", result.scene_file.generic_string(), result.error);
+                }
+                result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - scene_start).count();
+            });
+        }
+        scenes.wait();
+    }
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return summary;
+}
+
+void print_batch_summary(const BatchSummary &summary) noexcept {
+    println("\n{:<8} {:>10}  {}", "Status", "Time (s)", "Scene");
+    for (auto &&s : summary.scenes) {
+        println("{:<8} {:>10.3f}  {}", s.succeeded ? "OK" : "FAILED", s.seconds, s.scene_file.generic_string());
+    }
+    auto failures = summary.failure_count();
+    println("Converted {} of {} scenes in {:.3f} s.",
+            summary.scenes.size() - failures, summary.scenes.size(), summary.seconds);
+    for (auto &&s : summary.scenes) {
+        if (!s.succeeded) { eprintln("  {}: {}", s.scene_file.generic_string(), s.error); }
+    }
+}
+
+void save_batch_summary(const std::filesystem::path &file, const BatchSummary &summary) {
+    auto scenes = nlohmann::json::array();
+    for (auto &&s : summary.scenes) {
+        auto scene = nlohmann::json{{"file", s.scene_file.generic_string()},
+                                    {"succeeded", s.succeeded},
+                                    {"seconds", s.seconds}};
+        if (!s.succeeded) { scene["error"] = s.error; }
+        scenes.emplace_back(std::move(scene));
+    }
+    auto failures = summary.failure_count();
+    std::ofstream f{file};
+    expect(f.is_open(), "Failed to open batch summary {}.", file.generic_string());
+    f << nlohmann::json{{"version", 1},
+                        {"seconds", summary.seconds},
+                        {"succeeded", summary.scenes.size() - failures},
+                        {"failed", failures},
+                        {"scenes", std::move(scenes)}}
+             .dump(4);
+}
+
+}// namespace luisa::render
@@ -0,0 +1,44 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "convert.h"
+
+namespace luisa::render {
+
+struct BatchSceneResult {
+    std::filesystem::path scene_file;
+    bool succeeded{false};
+    std::string error;// empty if succeeded
+    double seconds{0.};
+};
+
+struct BatchSummary {
+    std::vector<BatchSceneResult> scenes;
+    double seconds{0.};
+    [[nodiscard]] size_t failure_count() const noexcept;
+};
+
+// Expands the directories among the inputs into the .pbrt files found in them
+// recursively, skipping files without a WorldBegin statement as those are most
+// likely included by other scenes. Other inputs are taken as scene files as is.
+[[nodiscard]] std::vector<std::filesystem::path> collect_scene_files(
+    const std::vector<std::filesystem::path> &inputs);
+
+// Converts the scenes concurrently on one thread pool with options.jobs threads,
+// which also exports their meshes. A scene that fails is reported in its result
+// without affecting the others. Per-scene profiling is disabled, as concurrent
+// scenes would share the stage timings and peak memory of the process.
+[[nodiscard]] BatchSummary convert_batch(const std::vector<std::filesystem::path> &scene_files,
+                                         const ConvertOptions &options) noexcept;
+
+void print_batch_summary(const BatchSummary &summary) noexcept;
+void save_batch_summary(const std::filesystem::path &file, const BatchSummary &summary);
+
+}// namespace luisa::render
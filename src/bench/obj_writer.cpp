@@ -0,0 +1,118 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <charconv>
+#include <filesystem>
+#include <string_view>
+
+#include <minipbrt.h>
+
+#include "logging.h"
+#include "mesh_writer.h"
+
+// The per-line luisa::format + std::ofstream writer that the buffered
+// OBJ writer replaced, kept here as the baseline.
+static void dump_mesh_to_wavefront_obj_baseline(
+    const std::filesystem::path &file_name,
+    const minipbrt::TriangleMesh *mesh) {
+    std::ofstream f{file_name};
+    f << "# Converted from PLY mesh\n";
+    for (auto v = 0u; v < mesh->num_vertices; v++) {
+        f << luisa::format("v {} {} {}\n", mesh->P[v * 3 + 0], mesh->P[v * 3 + 1], mesh->P[v * 3 + 2]);
+    }
+    for (auto v = 0u; v < mesh->num_vertices; v++) {
+        f << luisa::format("vn {} {} {}\n", mesh->N[v * 3 + 0], mesh->N[v * 3 + 1], mesh->N[v * 3 + 2]);
+    }
+    for (auto v = 0u; v < mesh->num_vertices; v++) {
+        f << luisa::format("vt {} {}\n", mesh->uv[v * 2 + 0], mesh->uv[v * 2 + 1]);
+    }
+    auto p = [](std::ofstream &f, int i0, int i1, int i2) {
+        f << luisa::format("f {}/{}/{} {}/{}/{} {}/{}/{}\n", i0, i0, i0, i1, i1, i1, i2, i2, i2);
+    };
+    for (auto i = 0u; i < mesh->num_indices; i += 3) {
+        p(f, mesh->indices[i + 0] + 1, mesh->indices[i + 1] + 1, mesh->indices[i + 2] + 1);
+    }
+}
+
+// a wavy n x n grid with normals and uvs
+static void make_grid_mesh(minipbrt::TriangleMesh &mesh, uint32_t n) noexcept {
+    auto nv = (n + 1u) * (n + 1u);
+    mesh.num_vertices = nv;
+    mesh.num_indices = n * n * 6u;
+    mesh.P = new float[nv * 3u];
+    mesh.N = new float[nv * 3u];
+    mesh.uv = new float[nv * 2u];
+    mesh.indices = new int[mesh.num_indices];
+    for (auto y = 0u; y <= n; y++) {
+        for (auto x = 0u; x <= n; x++) {
+            auto v = y * (n + 1u) + x;
+            auto u = static_cast<float>(x) / static_cast<float>(n);
+            auto w = static_cast<float>(y) / static_cast<float>(n);
+            auto h = .1f * std::sin(u * 37.f) * std::cos(w * 29.f);
+            mesh.P[v * 3u + 0u] = u * 2.f - 1.f;
+            mesh.P[v * 3u + 1u] = h;
+            mesh.P[v * 3u + 2u] = w * 2.f - 1.f;
+            mesh.N[v * 3u + 0u] = 0.f;
+            mesh.N[v * 3u + 1u] = 1.f;
+            mesh.N[v * 3u + 2u] = 0.f;
+            mesh.uv[v * 2u + 0u] = u;
+            mesh.uv[v * 2u + 1u] = w;
+        }
+    }
+    for (auto y = 0u; y < n; y++) {
+        for (auto x = 0u; x < n; x++) {
+            auto v0 = static_cast<int>(y * (n + 1u) + x);
+            auto v1 = v0 + 1;
+            auto v2 = v0 + static_cast<int>(n + 1u);
+            auto v3 = v2 + 1;
+            auto i = (y * n + x) * 6u;
+            mesh.indices[i + 0u] = v0;
+            mesh.indices[i + 1u] = v1;
+            mesh.indices[i + 2u] = v3;
+            mesh.indices[i + 3u] = v0;
+            mesh.indices[i + 4u] = v3;
+            mesh.indices[i + 5u] = v2;
+        }
+    }
+}
+
+template<typename F>
+static void measure(std::string_view label, const std::filesystem::path &file_name,
+                    const minipbrt::TriangleMesh &mesh, F &&f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f(file_name, &mesh);
+    auto t1 = std::chrono::steady_clock::now();
+    auto seconds = std::chrono::duration<double>(t1 - t0).count();
+    auto bytes = static_cast<double>(std::filesystem::file_size(file_name));
+    luisa::println("{:<12} {:8.3f} s {:10.2f} MB/s {:8.2f} Mtri/s {:10.2f} MB",
+                   label, seconds, bytes / seconds * 1e-6,
+                   mesh.num_indices / 3u / seconds * 1e-6, bytes * 1e-6);
+    std::filesystem::remove(file_name);
+}
+
+int main(int argc, char *argv[]) {
+    // usage: pbrt2luisa-bench-obj [triangles] [output directory]
+    auto triangles = 10'000'000u;
+    if (argc > 1) {
+        std::string_view arg{argv[1]};
+        auto [end, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), triangles);
+        luisa::expect(ec == std::errc{} && triangles != 0u, "Invalid triangle count '{}'.", arg);
+    }
+    auto dir = argc > 2 ? std::filesystem::path{argv[2]} : std::filesystem::temp_directory_path();
+    auto n = static_cast<uint32_t>(std::ceil(std::sqrt(triangles / 2.)));
+    minipbrt::TriangleMesh mesh;
+    make_grid_mesh(mesh, n);
+    luisa::println("Mesh: {} vertices, {} triangles.", mesh.num_vertices, mesh.num_indices / 3u);
+    auto file_name = dir / "pbrt2luisa-bench-obj.obj";
+    measure("baseline", file_name, mesh, dump_mesh_to_wavefront_obj_baseline);
+    measure("buffered", file_name, mesh, [](auto &&file_name, auto mesh) {
+        luisa::render::dump_mesh_to_wavefront_obj(file_name, luisa::render::make_mesh_view(mesh));
+    });
+    measure("binary-ply", dir / "pbrt2luisa-bench-obj.ply", mesh, [](auto &&file_name, auto mesh) {
+        luisa::render::dump_mesh_to_binary_ply(file_name, luisa::render::make_mesh_view(mesh));
+    });
+}
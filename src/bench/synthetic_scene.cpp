@@ -0,0 +1,353 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <charconv>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+#include <minipbrt.h>
+
+#include "logging.h"
+#include "mesh_view.h"
+#include "mesh_writer.h"
+#include "convert.h"
+
+struct SceneConfig {
+    uint32_t meshes{64u};
+    uint32_t vertices{65536u};// per mesh
+    uint32_t instances{0u};   // 0 to place the meshes directly instead of as objects
+    uint32_t textures{16u};
+    uint32_t materials{16u};
+    uint32_t texture_size{256u};
+    bool normals{true};
+    bool uvs{true};
+    bool ply_meshes{false};// binary PLY files instead of inline trianglemesh shapes
+};
+
+[[nodiscard]] static uint32_t parse_uint(std::string_view option, std::string_view value) {
+    auto x = 0u;
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), x);
+    luisa::expect(ec == std::errc{} && end == value.data() + value.size(),
+                  "Invalid value '{}' for option '{}'.", value, option);
+    return x;
+}
+
+// a wavy n x n grid; the waves differ per mesh so that deduplication does not merge them
+static void make_grid_mesh(minipbrt::TriangleMesh &mesh, uint32_t n, uint32_t seed,
+                           bool normals, bool uvs) noexcept {
+    auto nv = (n + 1u) * (n + 1u);
+    mesh.num_vertices = nv;
+    mesh.num_indices = n * n * 6u;
+    mesh.P = new float[nv * 3u];
+    mesh.N = normals ? new float[nv * 3u] : nullptr;
+    mesh.uv = uvs ? new float[nv * 2u] : nullptr;
+    mesh.indices = new int[mesh.num_indices];
+    auto phase = static_cast<float>(seed) * .37f;
+    for (auto y = 0u; y <= n; y++) {
+        for (auto x = 0u; x <= n; x++) {
+            auto v = y * (n + 1u) + x;
+            auto u = static_cast<float>(x) / static_cast<float>(n);
+            auto w = static_cast<float>(y) / static_cast<float>(n);
+            auto h = .1f * std::sin(u * 37.f + phase) * std::cos(w * 29.f - phase);
+            mesh.P[v * 3u + 0u] = u * 2.f - 1.f;
+            mesh.P[v * 3u + 1u] = h;
+            mesh.P[v * 3u + 2u] = w * 2.f - 1.f;
+            if (normals) {
+                mesh.N[v * 3u + 0u] = 0.f;
+                mesh.N[v * 3u + 1u] = 1.f;
+                mesh.N[v * 3u + 2u] = 0.f;
+            }
+            if (uvs) {
+                mesh.uv[v * 2u + 0u] = u;
+                mesh.uv[v * 2u + 1u] = w;
+            }
+        }
+    }
+    for (auto y = 0u; y < n; y++) {
+        for (auto x = 0u; x < n; x++) {
+            auto v0 = static_cast<int>(y * (n + 1u) + x);
+            auto v1 = v0 + 1;
+            auto v2 = v0 + static_cast<int>(n + 1u);
+            auto v3 = v2 + 1;
+            auto i = (y * n + x) * 6u;
+            mesh.indices[i + 0u] = v0;
+            mesh.indices[i + 1u] = v1;
+            mesh.indices[i + 2u] = v3;
+            mesh.indices[i + 3u] = v0;
+            mesh.indices[i + 4u] = v3;
+            mesh.indices[i + 5u] = v2;
+        }
+    }
+}
+
+template<typename T>
+static void append_numbers(std::string &s, const T *values, size_t count) noexcept {
+    char buffer[32];
+    s.append("[");
+    for (auto i = 0u; i < count; i++) {
+        auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), values[i]);
+        s.append(buffer, end).append(i % 16u == 15u ? "\n" : " ");
+    }
+    s.append("]");
+}
+
+// an inline trianglemesh shape, or a binary PLY file and a plymesh shape referencing it
+static void write_mesh_shape(std::string &s, const std::filesystem::path &dir,
+                             const minipbrt::TriangleMesh &mesh, uint32_t index, bool ply) {
+    if (ply) {
+        auto file_name = luisa::format("meshes/mesh_{:05}.ply", index);
+        luisa::render::dump_mesh_to_binary_ply(dir / file_name, luisa::render::make_mesh_view(&mesh));
+        s.append(luisa::format("Shape \"plymesh\" \"string filename\" \"{}\"\n", file_name));
+        return;
+    }
+    s.append("Shape \"trianglemesh\"\n\"integer indices\" ");
+    append_numbers(s, mesh.indices, mesh.num_indices);
+    s.append("\n\"point P\" ");
+    append_numbers(s, mesh.P, mesh.num_vertices * 3u);
+    if (mesh.N != nullptr) {
+        s.append("\n\"normal N\" ");
+        append_numbers(s, mesh.N, mesh.num_vertices * 3u);
+    }
+    if (mesh.uv != nullptr) {
+        s.append("\n\"float uv\" ");
+        append_numbers(s, mesh.uv, mesh.num_vertices * 2u);
+    }
+    s.append("\n");
+}
+
+// a small gradient image in the portable float map format
+static void write_texture_image(const std::filesystem::path &file_name, uint32_t size, uint32_t seed) {
+    std::vector<float> pixels(size * size * 3u);
+    for (auto y = 0u; y < size; y++) {
+        for (auto x = 0u; x < size; x++) {
+            auto p = &pixels[(y * size + x) * 3u];
+            p[0] = static_cast<float>(x) / static_cast<float>(size);
+            p[1] = static_cast<float>(y) / static_cast<float>(size);
+            p[2] = static_cast<float>(seed % 16u) / 16.f;
+        }
+    }
+    std::ofstream f{file_name, std::ios::binary};
+    f << luisa::format("PF\n{} {}\n-1.0\n", size, size);
+    f.write(reinterpret_cast<const char *>(pixels.data()), static_cast<std::streamsize>(pixels.size() * sizeof(float)));
+    luisa::expect(f.good(), "Failed to write texture image {}.", file_name.generic_string());
+}
+
+// marks the directories written by the benchmark, which it may wipe on the next run
+static constexpr auto bench_marker_file = ".pbrt2luisa-bench";
+
+// Writes <dir>/scene.pbrt, with PLY meshes in <dir>/meshes and images in <dir>/textures.
+// Returns the number of triangles in the meshes, without counting instances.
+static uint64_t generate_scene(const std::filesystem::path &dir, const SceneConfig &config) {
+    // only directories of earlier runs are cleared, never ones the user filled
+    if (std::filesystem::exists(dir)) {
+        luisa::expect(std::filesystem::is_directory(dir), "Output path {} is not a directory.", dir.generic_string());
+        luisa::expect(std::filesystem::is_empty(dir) || std::filesystem::exists(dir / bench_marker_file),
+                      "Refusing to overwrite non-empty directory {} not written by the benchmark.", dir.generic_string());
+        std::filesystem::remove_all(dir);
+    }
+    std::filesystem::create_directories(dir / "textures");
+    std::ofstream{dir / bench_marker_file};
+    if (config.ply_meshes) { std::filesystem::create_directories(dir / "meshes"); }
+    std::ofstream file{dir / "scene.pbrt"};
+    std::string s;
+    s.append("LookAt 0 4 -6  0 0 0  0 1 0\n"
+             "Camera \"perspective\" \"float fov\" [45]\n"
+             "Film \"image\" \"integer xresolution\" [1280] \"integer yresolution\" [720] \"string filename\" \"scene.exr\"\n"
+             "Sampler \"random\" \"integer pixelsamples\" [64]\n"
+             "Integrator \"path\" \"integer maxdepth\" [10]\n"
+             "WorldBegin\n"
+             "AttributeBegin\n"
+             "LightSource \"infinite\" \"rgb L\" [1 1 1]\n"
+             "AttributeEnd\n");
+    for (auto i = 0u; i < config.textures; i++) {
+        auto file_name = luisa::format("textures/texture_{:05}.pfm", i);
+        write_texture_image(dir / file_name, config.texture_size, i);
+        s.append(luisa::format("Texture \"texture_{}\" \"spectrum\" \"imagemap\" \"string filename\" \"{}\"\n", i, file_name));
+    }
+    for (auto i = 0u; i < config.materials; i++) {
+        if (config.textures != 0u) {
+            s.append(luisa::format("MakeNamedMaterial \"material_{}\" \"string type\" \"matte\" \"texture Kd\" \"texture_{}\"\n",
+                                   i, i % config.textures));
+        } else {
+            s.append(luisa::format("MakeNamedMaterial \"material_{}\" \"string type\" \"matte\" \"rgb Kd\" [{} .5 .5]\n",
+                                   i, static_cast<float>(i) / static_cast<float>(config.materials)));
+        }
+    }
+    auto n = std::max(static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(config.vertices)))), 2u) - 1u;
+    auto triangles = uint64_t{0u};
+    for (auto i = 0u; i < config.meshes; i++) {
+        minipbrt::TriangleMesh mesh;
+        make_grid_mesh(mesh, n, i, config.normals, config.uvs);
+        triangles += mesh.num_indices / 3u;
+        auto material = config.materials == 0u ? std::string{} :
+                                                 luisa::format("NamedMaterial \"material_{}\"\n", i % config.materials);
+        if (config.instances == 0u) {
+            s.append("AttributeBegin\n").append(material);
+            s.append(luisa::format("Translate {} 0 {}\n", (i % 16u) * 2.5f, (i / 16u) * 2.5f));
+            write_mesh_shape(s, dir, mesh, i, config.ply_meshes);
+            s.append("AttributeEnd\n");
+        } else {
+            s.append(luisa::format("ObjectBegin \"object_{}\"\n", i)).append(material);
+            write_mesh_shape(s, dir, mesh, i, config.ply_meshes);
+            s.append("ObjectEnd\n");
+        }
+        file << s;
+        s.clear();
+    }
+    if (config.meshes != 0u) {
+        for (auto i = 0u; i < config.instances; i++) {
+            s.append(luisa::format("AttributeBegin\n"
+                                   "Translate {} 0 {}\n"
+                                   "Rotate {} 0 1 0\n"
+                                   "ObjectInstance \"object_{}\"\n"
+                                   "AttributeEnd\n",
+                                   (i % 32u) * 2.5f, (i / 32u) * 2.5f, (i * 37u) % 360u, i % config.meshes));
+        }
+    }
+    s.append("WorldEnd\n");
+    file << s;
+    luisa::expect(file.good(), "Failed to write the generated scene to {}.", dir.generic_string());
+    return triangles;
+}
+
+// removes the converter's outputs from a previous run, keeping the generated inputs
+static void remove_converted_files(const std::filesystem::path &dir) {
+    std::vector<std::filesystem::path> outputs;
+    for (auto &&entry : std::filesystem::directory_iterator{dir}) {
+        if (auto name = entry.path().filename().generic_string();
+            name != "scene.pbrt" && name != "meshes" && name != "textures" && name != bench_marker_file) {
+            outputs.emplace_back(entry.path());
+        }
+    }
+    for (auto &&p : outputs) { std::filesystem::remove_all(p); }
+}
+
+int main(int argc, char *argv[]) {
+    SceneConfig config;
+    luisa::render::ConvertOptions options;
+    auto repeats = 3u;
+    auto dir = std::filesystem::temp_directory_path() / "pbrt2luisa-bench";
+    for (auto i = 1; i < argc; i++) {
+        std::string_view arg{argv[i]};
+        auto value = [&] {
+            luisa::expect(i + 1 < argc, "Missing value for option '{}'.", arg);
+            return std::string_view{argv[++i]};
+        };
+        if (arg == "--meshes") {
+            config.meshes = parse_uint(arg, value());
+        } else if (arg == "--vertices") {
+            config.vertices = parse_uint(arg, value());
+        } else if (arg == "--instances") {
+            config.instances = parse_uint(arg, value());
+        } else if (arg == "--textures") {
+            config.textures = parse_uint(arg, value());
+        } else if (arg == "--materials") {
+            config.materials = parse_uint(arg, value());
+        } else if (arg == "--texture-size") {
+            config.texture_size = std::max(parse_uint(arg, value()), 1u);
+        } else if (arg == "--no-normals") {
+            config.normals = false;
+        } else if (arg == "--no-uvs") {
+            config.uvs = false;
+        } else if (arg == "--ply-meshes") {
+            config.ply_meshes = true;
+        } else if (arg == "--repeat") {
+            repeats = std::max(parse_uint(arg, value()), 1u);
+        } else if (arg == "-j" || arg == "--jobs") {
+            options.jobs = parse_uint(arg, value());
+        } else if (arg == "--mesh-format") {
+            auto f = value();
+            luisa::expect(f == "obj" || f == "ply", "Invalid value '{}' for option '{}'.", f, arg);
+            options.mesh_format = f == "obj" ? luisa::render::MeshFormat::OBJ : luisa::render::MeshFormat::PLY;
+        } else if (arg == "--compact") {
+            options.scene_format = luisa::render::SceneFormat::CompactJSON;
+        } else if (arg == "--mmap-ply") {
+            options.mmap_ply = true;
+        } else if (arg.starts_with("-")) {
+            luisa::println("Usage: {} [options] [output directory]\n"
+                           "The output directory must be empty or from an earlier run, as it is cleared.\n"
+                           "Scene options:\n"
+                           "  --meshes N          number of distinct meshes (default: 64)\n"
+                           "  --vertices V        vertices per mesh (default: 65536)\n"
+                           "  --instances K       define the meshes as objects and place K instances (default: 0)\n"
+                           "  --textures T        number of image textures (default: 16)\n"
+                           "  --materials M       number of materials (default: 16)\n"
+                           "  --texture-size S    width and height of the images (default: 256)\n"
+                           "  --no-normals        omit vertex normals\n"
+                           "  --no-uvs            omit texture coordinates\n"
+                           "  --ply-meshes        store the meshes as binary PLY files\n"
+                           "Benchmark options:\n"
+                           "  --repeat R          number of conversions to run (default: 3)\n"
+                           "  -j, --jobs N, --mesh-format obj|ply, --compact, --mmap-ply\n"
+                           "                      passed on to the converter",
+                           argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        } else {
+            dir = argv[i];
+        }
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    auto triangles = generate_scene(dir, config);
+    auto t1 = std::chrono::steady_clock::now();
+    auto input_bytes = uint64_t{0u};
+    for (auto &&entry : std::filesystem::recursive_directory_iterator{dir}) {
+        if (entry.is_regular_file()) { input_bytes += entry.file_size(); }
+    }
+    luisa::println("Generated {} meshes ({} triangles), {} instances, {} textures and {} materials "
+                   "({:.2f} MB) in {:.3f} s.",
+                   config.meshes, triangles, config.instances, config.textures, config.materials,
+                   input_bytes * 1e-6, std::chrono::duration<double>(t1 - t0).count());
+
+    // the per-stage numbers are taken from the profile report of each run
+    auto report_file = dir / "profile.json";
+    options.profile_report = report_file;
+    struct Run {
+        double seconds;
+        nlohmann::json report;
+    };
+    std::vector<Run> runs;
+    for (auto r = 0u; r < repeats; r++) {
+        remove_converted_files(dir);
+        auto start = std::chrono::steady_clock::now();
+        luisa::render::convert((dir / "scene.pbrt").generic_string().c_str(), options);
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::ifstream f{report_file};
+        runs.emplace_back(Run{seconds, nlohmann::json::parse(f)});
+    }
+
+    luisa::println("\n{:<6} {:>10} {:>12} {:>12} {:>12} {:>14}",
+                   "Run", "Time (s)", "Mtri/s", "Written (MB)", "MB/s", "Peak RSS (MB)");
+    for (auto r = 0u; r < runs.size(); r++) {
+        auto &&[seconds, report] = runs[r];
+        auto bytes = uint64_t{0u};
+        auto peak = uint64_t{0u};
+        for (auto &&stage : report["stages"]) {
+            if (stage["depth"] == 0) { bytes += stage["bytes_written"].get<uint64_t>(); }
+            peak = std::max(peak, stage.value("peak_rss", uint64_t{0u}));
+        }
+        luisa::println("{:<6} {:>10.3f} {:>12.2f} {:>12.2f} {:>12.2f} {:>14.2f}",
+                       r, seconds, triangles / seconds * 1e-6, bytes * 1e-6, bytes / seconds * 1e-6, peak * 1e-6);
+    }
+    auto best = std::min_element(runs.cbegin(), runs.cend(), [](auto &&a, auto &&b) noexcept {
+        return a.seconds < b.seconds;
+    });
+    luisa::println("\nStages of the fastest run:");
+    luisa::println("{:<32} {:>10} {:>12} {:>12} {:>14}", "Stage", "Time (s)", "Written (MB)", "MB/s", "Peak RSS (MB)");
+    for (auto &&stage : best->report["stages"]) {
+        auto name = luisa::format("{:{}}{}", "", stage["depth"].get<uint32_t>() * 2u, stage["name"].get<std::string>());
+        auto seconds = stage["seconds"].get<double>();
+        auto bytes = stage["bytes_written"].get<uint64_t>();
+        auto peak = stage.value("peak_rss", uint64_t{0u});
+        luisa::println("{:<32} {:>10.3f} {:>12.2f} {:>12} {:>14}", name, seconds, bytes * 1e-6,
+                       bytes == 0u || seconds <= 0. ? "-" : luisa::format("{:.2f}", bytes / seconds * 1e-6),
+                       peak == 0u ? "-" : luisa::format("{:.2f}", peak * 1e-6));
+    }
+}
@@ -0,0 +1,108 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <fstream>
+#include <utility>
+#include <optional>
+
+#include "logging.h"
+#include "cache.h"
+
+namespace luisa::render {
+
+ConversionCache::ConversionCache(const std::filesystem::path &base_dir,
+                                 std::string_view name, bool enabled) noexcept
+    : _base_dir{base_dir},
+      _manifest{base_dir / luisa::format("{}.manifest.json", name)},
+      _previous(nlohmann::json::object()),
+      _current(nlohmann::json::object()),
+      _previous_inputs(nlohmann::json::object()),
+      _current_inputs(nlohmann::json::object()),
+      _enabled{enabled} {
+    if (!_enabled || !std::filesystem::exists(_manifest)) { return; }
+    try {
+        std::ifstream f{_manifest};
+        auto manifest = nlohmann::json::parse(f);
+        if (manifest.value("version", 0u) == version) {
+            _previous = std::move(manifest["files"]);
+            _previous_inputs = manifest.value("inputs", nlohmann::json::object());
+        } else {
+            println("Ignored conversion cache {} from another version.", _manifest.generic_string());
+        }
+    } catch (const std::exception &e) {
+        eprintln("Ignored invalid conversion cache {}: {}.", _manifest.generic_string(), e.what());
+    }
+}
+
+// the size, or nullopt if the file is missing, and the modification time in ticks of the file clock
+[[nodiscard]] static std::pair<std::optional<uint64_t>, int64_t> file_size_and_mtime(const std::filesystem::path &file) noexcept {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(file, ec);
+    if (ec) { return {std::nullopt, 0}; }
+    auto mtime = std::filesystem::last_write_time(file, ec);
+    if (ec) { return {std::nullopt, 0}; }
+    return {size, static_cast<int64_t>(mtime.time_since_epoch().count())};
+}
+
+bool ConversionCache::is_up_to_date(std::string_view output, uint64_t input_hash) const noexcept {
+    if (!_enabled) { return false; }
+    auto iter = _previous.find(output);
+    if (iter == _previous.end() ||
+        iter->value("input", "") != luisa::format("{:016x}", input_hash)) {
+        return false;
+    }
+    auto [size, mtime] = file_size_and_mtime(_base_dir / output);
+    return size && *size == iter->value("size", ~0ull) &&
+           mtime == iter->value("mtime", int64_t{0});
+}
+
+void ConversionCache::record(std::string_view output, uint64_t input_hash) noexcept {
+    if (!_enabled) { return; }
+    auto [size, mtime] = file_size_and_mtime(_base_dir / output);
+    if (!size) { return; }
+    std::scoped_lock lock{_mutex};
+    _current[output] = {{"input", luisa::format("{:016x}", input_hash)},
+                        {"size", *size},
+                        {"mtime", mtime}};
+}
+
+std::optional<nlohmann::json> ConversionCache::find_input(const std::filesystem::path &input) const noexcept {
+    if (!_enabled) { return std::nullopt; }
+    auto iter = _previous_inputs.find(input.generic_string());
+    if (iter == _previous_inputs.end()) { return std::nullopt; }
+    auto [size, mtime] = file_size_and_mtime(input);
+    if (!size || *size != iter->value("size", ~0ull) ||
+        mtime != iter->value("mtime", int64_t{0})) {
+        return std::nullopt;
+    }
+    return iter->value("facts", nlohmann::json::object());
+}
+
+void ConversionCache::record_input(const std::filesystem::path &input, const nlohmann::json &facts) noexcept {
+    if (!_enabled) { return; }
+    auto [size, mtime] = file_size_and_mtime(input);
+    if (!size) { return; }
+    std::scoped_lock lock{_mutex};
+    auto &entry = _current_inputs[input.generic_string()];
+    // an input used by several shapes may be recorded by each
+    if (!entry.is_object() || entry.value("size", ~0ull) != *size || entry.value("mtime", int64_t{0}) != mtime) {
+        entry = {{"size", *size}, {"mtime", mtime}, {"facts", nlohmann::json::object()}};
+    }
+    entry["facts"].update(facts);
+}
+
+void ConversionCache::save() const noexcept {
+    if (!_enabled) { return; }
+    std::ofstream f{_manifest};
+    f << nlohmann::json{{"version", version}, {"files", _current}, {"inputs", _current_inputs}}.dump(4);
+}
+
+void ConversionCache::remove_manifest() const noexcept {
+    std::error_code ec;
+    if (std::filesystem::remove(_manifest, ec)) {
+        println("Removed conversion cache {} of an earlier incremental run.", _manifest.generic_string());
+    }
+}
+
+}// namespace luisa::render
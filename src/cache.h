@@ -0,0 +1,59 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <mutex>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+namespace luisa::render {
+
+// Persistent manifest of the files written by a conversion, keyed by the output
+// path relative to the scene directory. Each entry records a hash of the inputs
+// the file was produced from and the size and modification time of the file,
+// so a later run can skip rewriting outputs whose inputs have not changed and
+// that nothing else has rewritten since. Facts derived from reading an input
+// file, e.g. the hash of a mesh, are recorded as well, keyed by the size and
+// modification time of the input, so that unchanged inputs are not read again
+// just to find out that their outputs are up to date.
+class ConversionCache {
+
+public:
+    // bump whenever the content produced for the same inputs changes
+    static constexpr auto version = 3u;
+
+private:
+    std::filesystem::path _base_dir;
+    std::filesystem::path _manifest;
+    nlohmann::json _previous;
+    nlohmann::json _current;
+    nlohmann::json _previous_inputs;
+    nlohmann::json _current_inputs;
+    std::mutex _mutex;
+    bool _enabled;
+
+public:
+    ConversionCache(const std::filesystem::path &base_dir,
+                    std::string_view name, bool enabled) noexcept;
+    [[nodiscard]] auto enabled() const noexcept { return _enabled; }
+    // whether the previous run wrote `output` from the same inputs and it is still intact
+    [[nodiscard]] bool is_up_to_date(std::string_view output, uint64_t input_hash) const noexcept;
+    // records an output that has been written (or found up to date), thread-safe
+    void record(std::string_view output, uint64_t input_hash) noexcept;
+    // the facts the previous run recorded for `input` if the file has the same size and
+    // modification time, or nullopt; record_input() adds to those kept for the next run
+    [[nodiscard]] std::optional<nlohmann::json> find_input(const std::filesystem::path &input) const noexcept;
+    void record_input(const std::filesystem::path &input, const nlohmann::json &facts) noexcept;
+    void save() const noexcept;
+    // Deletes the manifest of the previous run. Called by runs that write the outputs
+    // without the cache, as the manifest would describe files they overwrite.
+    void remove_manifest() const noexcept;
+};
+
+}// namespace luisa::render
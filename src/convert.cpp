@@ -2,9 +2,17 @@
 // Created by Mike on 2024/4/16.
 //
 
+#include <memory>
+#include <chrono>
+#include <utility>
+#include <optional>
 #include <fstream>
 #include <filesystem>
 #include <numbers>
+#include <numeric>
+#include <charconv>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <nlohmann/json.hpp>
 #include <magic_enum/magic_enum.hpp>
@@ -12,7 +20,23 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <minipbrt.h>
 
+#include "hash.h"
+#include "cache.h"
 #include "logging.h"
+#include "profiler.h"
+#include "thread_pool.h"
+#include "mesh_view.h"
+#include "mesh_writer.h"
+#include "mesh_optimizer.h"
+#include "ply_mesh.h"
+#include "mesh_splitter.h"
+#include "texture_stager.h"
+#include "transform_table.h"
+#include "scene_stats.h"
+#include "scene_sink.h"
+#include "scene_graph.h"
+#include "scene_passes.h"
+#include "scene_writer.h"
 #include "convert.h"
 
 namespace luisa::render {
@@ -55,6 +79,23 @@ namespace luisa::render {
         {"prop", {{"m", m}}}};
 }
 
+// the transform applying `inner` first and then `outer`
+[[nodiscard]] static minipbrt::Transform compose_transforms(const minipbrt::Transform &outer,
+                                                            const minipbrt::Transform &inner) noexcept {
+    auto t = inner;
+    for (auto i = 0; i < 4; i++) {
+        for (auto j = 0; j < 4; j++) {
+            t.start[i][j] = 0.f;
+            t.end[i][j] = 0.f;
+            for (auto k = 0; k < 4; k++) {
+                t.start[i][j] += outer.start[i][k] * inner.start[k][j];
+                t.end[i][j] += outer.end[i][k] * inner.end[k][j];
+            }
+        }
+    }
+    return t;
+}
+
 [[nodiscard]] static nlohmann::json convert_camera_transform(const minipbrt::Transform &transform) noexcept {
     // TODO: consider animated transform
     glm::mat4 m;
@@ -108,78 +149,13 @@ namespace luisa::render {
         {"prop", {{"m", {n[0][0], n[1][0], n[2][0], 0, n[0][1], n[1][1], n[2][1], 0, n[0][2], n[1][2], n[2][2], 0, 0, 0, 0, 1}}}}};
 }
 
-static void dump_mesh_to_wavefront_obj(
-    const std::filesystem::path &file_name,
-    const minipbrt::TriangleMesh *mesh) {
-    std::ofstream f{file_name};
-    f << "# Converted from PLY mesh\n";
-    for (auto v = 0u; v < mesh->num_vertices; v++) {
-        f << luisa::format("v {} {} {}\n",
-                           mesh->P[v * 3 + 0],
-                           mesh->P[v * 3 + 1],
-                           mesh->P[v * 3 + 2]);
-    }
-    if (mesh->N) {
-        for (auto v = 0u; v < mesh->num_vertices; v++) {
-            f << luisa::format("vn {} {} {}\n",
-                               mesh->N[v * 3 + 0],
-                               mesh->N[v * 3 + 1],
-                               mesh->N[v * 3 + 2]);
-        }
-    }
-    if (mesh->uv) {
-        for (auto v = 0u; v < mesh->num_vertices; v++) {
-            f << luisa::format("vt {} {}\n",
-                               mesh->uv[v * 2 + 0],
-                               mesh->uv[v * 2 + 1]);
-        }
-    }
-    expect(mesh->indices, "Mesh indices are null.");
-    expect(mesh->num_indices % 3 == 0, "Invalid number of indices.");
-    auto p = [&]() noexcept -> void (*)(std::ofstream &, int, int, int) {
-        if (mesh->N) {
-            if (mesh->uv) {
-                return [](std::ofstream &f, int i0, int i1, int i2) {
-                    f << luisa::format("f {}/{}/{} {}/{}/{} {}/{}/{}\n",
-                                       i0, i0, i0,
-                                       i1, i1, i1,
-                                       i2, i2, i2);
-                };
-            }
-            return [](std::ofstream &f, int i0, int i1, int i2) {
-                f << luisa::format("f {}//{} {}//{} {}//{}\n",
-                                   i0, i0,
-                                   i1, i1,
-                                   i2, i2);
-            };
-        }
-        if (mesh->uv) {
-            return [](std::ofstream &f, int i0, int i1, int i2) {
-                f << luisa::format("f {}/{} {}/{} {}/{}\n",
-                                   i0, i0,
-                                   i1, i1,
-                                   i2, i2);
-            };
-        }
-        return [](std::ofstream &f, int i0, int i1, int i2) {
-            f << luisa::format("f {} {} {}\n", i0, i1, i2);
-        };
-    }();
-    for (auto i = 0u; i < mesh->num_indices; i += 3) {
-        auto i0 = mesh->indices[i + 0] + 1;
-        auto i1 = mesh->indices[i + 1] + 1;
-        auto i2 = mesh->indices[i + 2] + 1;
-        p(f, i0, i1, i2);
-    }
-}
-
-[[nodiscard]] static std::string material_name(const minipbrt::Scene *scene, uint32_t index) noexcept {
+[[nodiscard]] static std::string material_name(const minipbrt::Scene *scene, uint32_t index) {
     expect(index != minipbrt::kInvalidIndex, "Invalid material index.");
     auto name = scene->materials[index]->name;
     return luisa::format("Surface:{}:{}", index, name ? name : "unnamed");
 }
 
-[[nodiscard]] static std::string texture_name(const minipbrt::Scene *scene, uint32_t index) noexcept {
+[[nodiscard]] static std::string texture_name(const minipbrt::Scene *scene, uint32_t index) {
     expect(index != minipbrt::kInvalidIndex, "Invalid texture index.");
     auto name = scene->textures[index]->name;
     return luisa::format("Texture:{}:{}", index, name ? name : "unnamed");
@@ -260,13 +236,344 @@ static void metal_eta_k_parsing(const minipbrt::Scene *scene,
     eprintln("Unsupported metal eta/k parsing.");
 }
 
+// A triangle mesh opened for export. The view is valid while the owner is alive.
+struct ExportMesh {
+    MeshView view;
+    std::shared_ptr<const void> owner;
+    // set if the mesh is a mapped binary PLY file, which can be copied as is to PLY output
+    std::filesystem::path ply_file;
+};
+
+// the file of a PLY mesh shape, relative paths being resolved against the scene directory
+[[nodiscard]] static std::filesystem::path resolve_ply_file(const std::filesystem::path &base_dir,
+                                                            const minipbrt::PLYMesh *ply) {
+    expect(ply->filename != nullptr, "PLY mesh filename is null.");
+    std::filesystem::path ply_file{ply->filename};
+    if (!ply_file.is_absolute()) { ply_file = base_dir / ply_file; }
+    return ply_file;
+}
+
+// Opens a shape that is exported as a triangle mesh. Shapes other than triangle
+// meshes are triangulated (or, for PLY meshes, loaded) on demand, and the result
+// is released together with the returned owner, so only the meshes being
+// exported at the moment are resident. Binary PLY files are memory-mapped if
+// requested; those that cannot be mapped are loaded by minipbrt instead.
+[[nodiscard]] static ExportMesh open_export_mesh(const std::filesystem::path &base_dir,
+                                                 const minipbrt::Shape *shape,
+                                                 bool mmap_ply) {
+    if (shape->type() == minipbrt::ShapeType::TriangleMesh) {
+        return {.view = make_mesh_view(static_cast<const minipbrt::TriangleMesh *>(shape))};
+    }
+    std::filesystem::path ply_file;
+    if (shape->type() == minipbrt::ShapeType::PLYMesh) {
+        ply_file = resolve_ply_file(base_dir, static_cast<const minipbrt::PLYMesh *>(shape));
+        if (mmap_ply) {
+            if (auto mapped = map_binary_ply_mesh(ply_file)) {
+                auto view = mapped->view;
+                return {.view = view,
+                        .owner = std::shared_ptr<const MappedPlyMesh>{std::move(mapped)},
+                        .ply_file = std::move(ply_file)};
+            }
+        }
+    }
+    std::shared_ptr<const minipbrt::TriangleMesh> mesh{shape->triangle_mesh()};
+    expect(mesh != nullptr, "Failed to triangulate {} shape{}.",
+           magic_enum::enum_name(shape->type()),
+           ply_file.empty() ? "" : luisa::format(" from {}", ply_file.generic_string()));
+    auto view = make_mesh_view(mesh.get());
+    return {.view = view, .owner = std::move(mesh)};
+}
+
+[[nodiscard]] static bool is_export_mesh(const minipbrt::Shape *shape) noexcept {
+    switch (shape->type()) {
+        case minipbrt::ShapeType::TriangleMesh:
+        case minipbrt::ShapeType::PLYMesh:
+        case minipbrt::ShapeType::Nurbs:
+        case minipbrt::ShapeType::LoopSubdiv:
+        case minipbrt::ShapeType::HeightField: return true;
+        default: break;
+    }
+    return false;
+}
+
+// the alpha texture overriding the material's, or kInvalidIndex
+[[nodiscard]] static uint32_t shape_alpha(const minipbrt::Shape *shape) noexcept {
+    switch (shape->type()) {
+        case minipbrt::ShapeType::TriangleMesh: return static_cast<const minipbrt::TriangleMesh *>(shape)->alpha;
+        case minipbrt::ShapeType::PLYMesh: return static_cast<const minipbrt::PLYMesh *>(shape)->alpha;
+        default: break;
+    }
+    return minipbrt::kInvalidIndex;
+}
+
+// References to the nodes that the converted shapes will refer to, i.e., the surfaces,
+// alpha textures and area lights of the shapes outside objects or in instanced ones.
+// Gathered from the scene, so that the graph passes can run before the shapes are converted.
+[[nodiscard]] static nlohmann::json collect_shape_references(const minipbrt::Scene *scene) {
+    std::unordered_set<std::string> references;
+    std::vector<uint8_t> instanced(scene->objects.size(), false);
+    for (auto &&instance : scene->instances) {
+        if (auto o = instance->object; o != minipbrt::kInvalidIndex) {
+            instanced[o] = true;
+            if (auto l = instance->areaLight; l != minipbrt::kInvalidIndex) {
+                references.emplace(luisa::format("@AreaLight:{}", l));
+            }
+        }
+    }
+    for (auto &&shape : scene->shapes) {
+        if (shape->object != minipbrt::kInvalidIndex && !instanced[shape->object]) { continue; }
+        if (auto m = shape->material; m != minipbrt::kInvalidIndex) {
+            references.emplace(luisa::format("@{}", material_name(scene, m)));
+        }
+        if (auto l = shape->areaLight; l != minipbrt::kInvalidIndex) {
+            references.emplace(luisa::format("@AreaLight:{}", l));
+        }
+        if (auto a = shape_alpha(shape); a != minipbrt::kInvalidIndex) {
+            references.emplace(luisa::format("@{}", texture_name(scene, a)));
+        }
+    }
+    return nlohmann::json(std::move(references));
+}
+
+// Maps each object to the instance it is inlined into, or kInvalidIndex. Objects are
+// inlined if they are used by a single instance and consist of triangle meshes
+// with at most `max_triangles` triangles in total; 0 disables inlining.
+[[nodiscard]] static std::vector<uint32_t> find_flattened_objects(const minipbrt::Scene *scene,
+                                                                  const std::vector<MeshStats> &mesh_stats,
+                                                                  uint32_t max_triangles) noexcept {
+    std::vector<uint32_t> flattened(scene->objects.size(), minipbrt::kInvalidIndex);
+    if (max_triangles == 0u) { return flattened; }
+    std::vector<uint32_t> uses(scene->objects.size(), 0u);
+    for (auto instance_index = 0u; instance_index < scene->instances.size(); instance_index++) {
+        if (auto o = scene->instances[instance_index]->object;
+            o != minipbrt::kInvalidIndex && scene->objects[o]->firstShape != minipbrt::kInvalidIndex) {
+            uses[o]++;
+            flattened[o] = instance_index;
+        }
+    }
+    for (auto object_index = 0u; object_index < scene->objects.size(); object_index++) {
+        auto object = scene->objects[object_index];
+        auto triangles = uint64_t{0u};
+        auto meshes_only = true;
+        for (auto s = 0u; meshes_only && s < object->numShapes; s++) {
+            auto shape_index = object->firstShape + s;
+            meshes_only = is_export_mesh(scene->shapes[shape_index]);
+            triangles += mesh_stats[shape_index].num_triangles;
+        }
+        if (uses[object_index] != 1u || !meshes_only || triangles > max_triangles) {
+            flattened[object_index] = minipbrt::kInvalidIndex;
+        }
+    }
+    return flattened;
+}
+
+// Converts the shapes, objects and instances, writing their nodes to `exported` as they are
+// produced, as no pass needs them: the graph holds the textures, surfaces and lights only,
+// already serialized, and is only read here to resolve and extend the surfaces.
 static void convert_shapes(
     const std::filesystem::path &base_dir,
     const minipbrt::Scene *scene,
     std::string_view name,
-    nlohmann::json &converted) {
+    const SceneGraph &graph,
+    SceneWriter &exported,
+    SceneSink *sink,
+    nlohmann::json &render,
+    SceneStats &stats,
+    const ConvertOptions &options,
+    ConversionCache &cache,
+    ThreadPool &pool,
+    Profiler &profiler) {
     auto mesh_dir = base_dir / "lr_exported_meshes";
-    std::filesystem::create_directories(mesh_dir);
+    if (sink == nullptr) { std::filesystem::create_directories(mesh_dir); }
+    // time spent in the worker tasks, summed over all threads
+    auto triangulate_stage = profiler.accumulated_stage("triangulate");
+    auto export_mesh_stage = profiler.accumulated_stage("export_mesh");
+    auto optimize_mesh_stage = profiler.accumulated_stage("optimize_mesh");
+    auto open_mesh = [&base_dir, &options, &profiler, triangulate_stage](const minipbrt::Shape *s) {
+        auto start = std::chrono::steady_clock::now();
+        auto mesh = open_export_mesh(base_dir, s, options.mmap_ply);
+        profiler.accumulate(triangulate_stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        return mesh;
+    };
+    // binary PLY meshes read in chunks, or nullptr if streaming is off or the layout is not supported
+    auto open_stream = [&base_dir, &options](const minipbrt::Shape *s) -> std::unique_ptr<PlyMeshStream> {
+        if (!options.stream_ply || s->type() != minipbrt::ShapeType::PLYMesh) { return nullptr; }
+        return PlyMeshStream::open(resolve_ply_file(base_dir, static_cast<const minipbrt::PLYMesh *>(s)));
+    };
+    std::vector<uint64_t> mesh_hashes(scene->shapes.size());
+    // counts of the meshes as exported, known after the analysis or once written
+    std::vector<MeshStats> mesh_stats(scene->shapes.size());
+    // whether the meshes are streamed, and how the large ones are split into parts
+    std::vector<uint8_t> streamed(scene->shapes.size(), false);
+    std::vector<std::optional<MeshSplitPlan>> split_plans(scene->shapes.size());
+    // the pool may be shared with other conversions, so only this scene's tasks are waited
+    // for; declared after the locals the tasks refer to, so that it waits for them on errors
+    TaskGroup tasks{pool};
+    // instancing needs the identical meshes found as well
+    auto deduplicate = options.deduplicate_meshes || options.auto_instance;
+    // hash the triangle meshes in parallel so that identical ones are exported only once;
+    // streamed meshes are only looked at in chunks and planned for splitting
+    if (auto analyze = deduplicate || cache.enabled() || options.flatten_objects_below != 0u;
+        analyze || options.stream_ply) {
+        auto scope = profiler.scope("hash_meshes");
+        for (auto shape_index = 0u; shape_index < scene->shapes.size(); shape_index++) {
+            if (auto s = scene->shapes[shape_index]; is_export_mesh(s)) {
+                tasks.dispatch([&, analyze, shape_index, s] {
+                    // With the cache, the hash and counts of a PLY file are recorded and taken
+                    // from the manifest while the file is unchanged, so that an incremental
+                    // rerun does not load or read through the file to find it up to date.
+                    auto ply_file = cache.enabled() && s->type() == minipbrt::ShapeType::PLYMesh ?
+                                        resolve_ply_file(base_dir, static_cast<const minipbrt::PLYMesh *>(s)) :
+                                        std::filesystem::path{};
+                    auto known = ply_file.empty() ? std::nullopt : cache.find_input(ply_file);
+                    auto known_hash = [&known](const char *key) noexcept -> std::optional<uint64_t> {
+                        if (!known) { return std::nullopt; }
+                        auto iter = known->find(key);
+                        if (iter == known->end() || !iter->is_string()) { return std::nullopt; }
+                        auto &&text = iter->get_ref<const std::string &>();
+                        auto hash = uint64_t{0u};
+                        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), hash, 16);
+                        if (ec != std::errc{} || end != text.data() + text.size()) { return std::nullopt; }
+                        return hash;
+                    };
+                    auto record = [&](const char *key, uint64_t hash, const MeshStats &stats) {
+                        if (ply_file.empty()) { return; }
+                        cache.record_input(ply_file, {{key, luisa::format("{:016x}", hash)},
+                                                      {"vertices", stats.num_vertices},
+                                                      {"triangles", stats.num_triangles},
+                                                      {"normals", stats.has_normals},
+                                                      {"uvs", stats.has_uvs}});
+                    };
+                    if (auto stream = open_stream(s)) {
+                        streamed[shape_index] = true;
+                        mesh_stats[shape_index] = {.num_vertices = stream->num_vertices(),
+                                                   .num_triangles = stream->num_triangles(),
+                                                   .has_normals = stream->has_normals(),
+                                                   .has_uvs = stream->has_uvs()};
+                        // reading the whole file for its hash only pays off with the cache, as
+                        // streamed meshes are not deduplicated
+                        if (cache.enabled()) {
+                            auto hash = known_hash("file_hash");
+                            mesh_hashes[shape_index] = hash ? *hash : stream->hash();
+                            record("file_hash", mesh_hashes[shape_index], mesh_stats[shape_index]);
+                        }
+                        if (auto limit = options.split_meshes_above;
+                            limit != 0u && stream->num_triangles() > limit) {
+                            split_plans[shape_index] = plan_mesh_split(*stream, limit);
+                        }
+                    } else if (auto hash = known_hash("mesh_hash"); hash && analyze) {
+                        mesh_hashes[shape_index] = *hash;
+                        mesh_stats[shape_index] = {.num_vertices = known->value("vertices", 0u),
+                                                   .num_triangles = known->value("triangles", 0u),
+                                                   .has_normals = known->value("normals", false),
+                                                   .has_uvs = known->value("uvs", false)};
+                        record("mesh_hash", *hash, mesh_stats[shape_index]);
+                    } else if (analyze) {
+                        // released right away, and opened again for the export, so that
+                        // only the meshes being worked on are resident
+                        auto mesh = open_mesh(s);
+                        mesh_hashes[shape_index] = hash_mesh(mesh.view);
+                        mesh_stats[shape_index] = MeshStats::of(mesh.view);
+                        record("mesh_hash", mesh_hashes[shape_index], mesh_stats[shape_index]);
+                    }
+                });
+            }
+        }
+        tasks.wait();
+    }
+    auto flattened_objects = find_flattened_objects(scene, mesh_stats, options.flatten_objects_below);
+    // shapes outside objects and in inlined objects are placed in the world directly
+    auto is_visible = [&flattened_objects](const minipbrt::Shape *s) noexcept {
+        return s->object == minipbrt::kInvalidIndex || flattened_objects[s->object] != minipbrt::kInvalidIndex;
+    };
+    // number of times the shapes are drawn: once if visible, once per instance of their object otherwise
+    std::vector<uint64_t> object_uses(scene->objects.size(), 0u);
+    for (auto &&instance : scene->instances) {
+        if (auto o = instance->object;
+            o != minipbrt::kInvalidIndex && flattened_objects[o] == minipbrt::kInvalidIndex) {
+            object_uses[o]++;
+        }
+    }
+    auto placements = [&](const minipbrt::Shape *s) noexcept {
+        return is_visible(s) ? uint64_t{1u} : object_uses[s->object];
+    };
+    // the name of the node kept for a surface or texture, which may have been merged into another one
+    auto resolved_name = [&graph](std::string name) {
+        if (auto node = graph.find(name)) { return graph.name(graph.resolve(*node)); }
+        return name;
+    };
+    // index of the shape whose mesh file each mesh shape refers to
+    std::vector<uint32_t> exported_indices(scene->shapes.size());
+    std::iota(exported_indices.begin(), exported_indices.end(), 0u);
+    if (deduplicate) {
+        auto scope = profiler.scope("deduplicate_meshes");
+        // The meshes were released after hashing, so those of equal hashes are opened
+        // again to be compared. The mesh being looked up is compared to each candidate
+        // of its hash in turn, so the last one opened on either side is kept open.
+        std::optional<std::pair<uint32_t, ExportMesh>> opened[2];
+        auto open_compared = [&](uint32_t side, uint32_t shape_index) -> const MeshView & {
+            if (auto &o = opened[side]; !o || o->first != shape_index) {
+                o.reset();
+                o.emplace(shape_index, open_mesh(scene->shapes[shape_index]));
+            }
+            return opened[side]->second.view;
+        };
+        // streamed meshes are too large to be compared and are always exported
+        exported_indices = find_identical_meshes(
+            mesh_hashes,
+            [&](uint32_t i) { return is_export_mesh(scene->shapes[i]) && !streamed[i]; },
+            [&](uint32_t a, uint32_t b) { return mesh_equal(open_compared(0u, a), open_compared(1u, b)); });
+    }
+    // number of visible shapes using each exported mesh; meshes used more than
+    // once are written as a single Mesh node that the shapes instance
+    std::vector<uint32_t> visible_uses(scene->shapes.size(), 0u);
+    if (options.auto_instance) {
+        for (auto shape_index = 0u; shape_index < scene->shapes.size(); shape_index++) {
+            if (auto s = scene->shapes[shape_index]; is_export_mesh(s) && is_visible(s)) {
+                visible_uses[exported_indices[shape_index]]++;
+            }
+        }
+    }
+    // the exported files depend on the optimization options as well, which are
+    // left out without optimization so that existing caches stay valid
+    auto export_hash = [&options](uint64_t mesh_hash) noexcept {
+        if (!options.optimize_meshes) { return mesh_hash; }
+        auto &o = options.mesh_optimization;
+        float settings[]{o.weld_epsilon, o.quantize_attributes ? 1.f : 0.f};
+        return hash64(settings, sizeof(settings), mesh_hash);
+    };
+    // instanced Mesh nodes and surfaces with alpha overrides already written
+    std::unordered_set<uint32_t> instanced_meshes;
+    std::unordered_set<std::string> alpha_surfaces;
+    // the table is written at the end, but its node first, as it is referenced by the others
+    TransformTable transform_table;
+    auto transform_table_file = luisa::format("{}.exported.transforms.bin", name);
+    if (options.transform_table) {
+        exported.write("TransformTable", {{"type", "TransformTable"},
+                                          {"impl", "Binary"},
+                                          {"prop", {{"file", transform_table_file}}}});
+    }
+    auto convert_node_transform = [&options, &transform_table](const minipbrt::Transform &transform) -> nlohmann::json {
+        auto t = convert_transform(transform);
+        if (!options.transform_table || t.is_null()) { return t; }
+        if (auto index = transform_table.add(transform.start)) {
+            return {{"impl", "Table"},
+                    {"prop", {{"table", "@TransformTable"}, {"index", *index}}}};
+        }
+        return t;// projective, kept as a matrix
+    };
+    // exported mesh files and their mesh hashes, recorded into the cache once written
+    std::vector<std::pair<std::string, uint64_t>> exported_files;
+    // placements of each exported mesh, summed over the shapes sharing it; meshes never
+    // placed are not written if unreferenced nodes are pruned, as their shapes will be
+    std::vector<uint64_t> mesh_placements(scene->shapes.size(), 0u);
+    for (auto shape_index = 0u; shape_index < scene->shapes.size(); shape_index++) {
+        if (auto s = scene->shapes[shape_index]; is_export_mesh(s)) {
+            mesh_placements[exported_indices[shape_index]] += placements(s);
+        }
+    }
+    // shapes whose meshes are written with their files
+    std::vector<std::pair<uint32_t, std::vector<std::string>>> written_meshes;
     // process shapes
     for (auto shape_index = 0u; shape_index < scene->shapes.size(); shape_index++) {
         auto base_shape = scene->shapes[shape_index];
@@ -277,19 +584,31 @@ static void convert_shapes(
         if (base_shape->reverseOrientation) {
             eprintln("Ignored unsupported shape reverse orientation at index {}.", shape_index);
         }
+        // with pruning, the nodes that shapes drawn nowhere refer to are gone, see collect_shape_references()
+        auto placed = !options.prune_unreferenced || placements(base_shape) != 0u;
         auto shape = nlohmann::json::object();
         shape["type"] = "Shape";
         auto &prop = (shape["prop"] = nlohmann::json::object());
+        // inlined objects take the transforms of the object and its instance
+        auto shape_to_world = base_shape->shapeToWorld;
+        auto area_light = base_shape->areaLight;
+        if (auto o = base_shape->object;
+            o != minipbrt::kInvalidIndex && flattened_objects[o] != minipbrt::kInvalidIndex) {
+            auto base_instance = scene->instances[flattened_objects[o]];
+            shape_to_world = compose_transforms(base_instance->instanceToWorld,
+                                                compose_transforms(scene->objects[o]->objectToInstance, shape_to_world));
+            if (base_instance->areaLight != minipbrt::kInvalidIndex) { area_light = base_instance->areaLight; }
+        }
         // transform
-        if (auto t = convert_transform(base_shape->shapeToWorld); !t.is_null()) {
+        if (auto t = convert_node_transform(shape_to_world); !t.is_null()) {
             prop["transform"] = std::move(t);
         }
         // surface
         if (auto m = base_shape->material; m != minipbrt::kInvalidIndex) {
-            prop["surface"] = luisa::format("@{}", material_name(scene, m));
+            prop["surface"] = luisa::format("@{}", resolved_name(material_name(scene, m)));
         }
         // light
-        if (auto l = base_shape->areaLight; l != minipbrt::kInvalidIndex) {
+        if (auto l = area_light; l != minipbrt::kInvalidIndex) {
             prop["light"] = luisa::format("@AreaLight:{}", l);
         }
         switch (auto shape_type = base_shape->type()) {
@@ -304,58 +623,204 @@ static void convert_shapes(
                        {{"impl", "SRT"},
                         {"prop",
                          {{"scale", sphere->radius}}}}}}}};
+                stats.add_analytic_shape(placements(base_shape));
                 break;
             }
-            case minipbrt::ShapeType::TriangleMesh: {
-                auto mesh = static_cast<const minipbrt::TriangleMesh *>(base_shape);
-                println("Converting triangle mesh at index {} to Wavefront OBJ.", shape_index);
-                dump_mesh_to_wavefront_obj(mesh_dir / luisa::format("{}.{:05}.obj", name, shape_index), mesh);
-                shape["impl"] = "Mesh";
-                prop["file"] = luisa::format("lr_exported_meshes/{}.{:05}.obj", name, shape_index);
-                if (auto a = mesh->alpha; a != minipbrt::kInvalidIndex) {// override the material's alpha
-                    auto alpha_texture_name = texture_name(scene, a);
-                    if (auto m = mesh->material; m == minipbrt::kInvalidIndex) {
+            case minipbrt::ShapeType::TriangleMesh:
+            case minipbrt::ShapeType::PLYMesh:
+            case minipbrt::ShapeType::Nurbs:
+            case minipbrt::ShapeType::LoopSubdiv:
+            case minipbrt::ShapeType::HeightField: {// triangulated on demand
+                auto exported_index = exported_indices[shape_index];
+                auto file_name = luisa::format("{}.{:05}.{}", name, exported_index,
+                                               mesh_format_extension(options.mesh_format));
+                auto exported_file = luisa::format("lr_exported_meshes/{}", file_name);
+                // split meshes are written as parts named <name>.<index>.<part>.<extension> instead
+                std::vector<std::string> part_files;
+                if (auto &plan = split_plans[shape_index]) {
+                    for (auto part = 0u; part < plan->part_count; part++) {
+                        part_files.emplace_back(luisa::format("lr_exported_meshes/{}.{:05}.{:03}.{}", name, shape_index, part,
+                                                              mesh_format_extension(options.mesh_format)));
+                    }
+                }
+                auto output_files = part_files.empty() ? std::vector{exported_file} : part_files;
+                auto output_hash = export_hash(mesh_hashes[shape_index]);
+                if (auto &plan = split_plans[shape_index]) {
+                    // the parts are renumbered if the mesh is split differently, so their
+                    // content depends on the limit and the resulting plan as well
+                    uint64_t split[]{options.split_meshes_above, plan->part_count};
+                    output_hash = hash64(split, sizeof(split), output_hash);
+                }
+                auto unplaced = options.prune_unreferenced && mesh_placements[exported_index] == 0u;
+                if (exported_index == shape_index && !unplaced) { written_meshes.emplace_back(shape_index, output_files); }
+                if (exported_index != shape_index) {
+                    println("Reusing identical mesh exported at index {} for shape at index {}.", exported_index, shape_index);
+                } else if (unplaced) {
+                    println("Skipped exporting triangle mesh at index {} as no instance places it.", shape_index);
+                } else if (std::all_of(output_files.cbegin(), output_files.cend(), [&](auto &&f) {
+                               return cache.is_up_to_date(f, output_hash);
+                           })) {
+                    println("Skipped exporting up-to-date triangle mesh at index {}.", shape_index);
+                    for (auto &&f : output_files) { exported_files.emplace_back(f, output_hash); }
+                } else if (streamed[shape_index]) {
+                    tasks.dispatch([&base_dir, &options, &profiler, &open_stream, &split_plans, export_mesh_stage,
+                                   base_shape, shape_index, output_files, path = mesh_dir / file_name] {
+                        auto format = options.mesh_format;
+                        auto stream = open_stream(base_shape);
+                        expect(stream != nullptr, "Failed to reopen streamed PLY mesh at index {}.", shape_index);
+                        auto start = std::chrono::steady_clock::now();
+                        auto size = uint64_t{0u};
+                        if (auto &plan = split_plans[shape_index]) {
+                            println("Splitting triangle mesh at index {} into {} parts.", shape_index, plan->part_count);
+                            auto temp_file = std::filesystem::path{path}.concat(".split");
+                            split_mesh(*stream, *plan, temp_file, [&](uint32_t part, const MeshView &mesh) {
+                                auto part_path = base_dir / output_files[part];
+                                dump_mesh(part_path, mesh, format);
+                                size += std::filesystem::file_size(part_path);
+                            });
+                        } else {
+                            if (format == MeshFormat::PLY) {// the streamed layout is a native binary PLY already
+                                println("Copying binary PLY mesh at index {} to {}.", shape_index, path.filename().generic_string());
+                                std::filesystem::copy_file(resolve_ply_file(base_dir, static_cast<const minipbrt::PLYMesh *>(base_shape)),
+                                                           path, std::filesystem::copy_options::overwrite_existing);
+                            } else {
+                                println("Streaming triangle mesh at index {} to {}.", shape_index, path.filename().generic_string());
+                                dump_mesh_stream(path, *stream, format);
+                            }
+                            size = std::filesystem::file_size(path);
+                        }
+                        profiler.add_bytes_written(size);
+                        profiler.accumulate(export_mesh_stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), size);
+                    });
+                    for (auto &&f : output_files) { exported_files.emplace_back(f, output_hash); }
+                } else {
+                    // the JSON graph is built in order on this thread, only the mesh files are written in parallel
+                    tasks.dispatch([&options, &profiler, &open_mesh, &mesh_stats, export_mesh_stage, optimize_mesh_stage,
+                                   sink, base_shape, shape_index, exported_file, path = mesh_dir / file_name] {
+                        auto format = options.mesh_format;
+                        auto mesh = open_mesh(base_shape);
+                        MeshBuffers optimized;
+                        if (options.optimize_meshes) {
+                            auto start = std::chrono::steady_clock::now();
+                            optimized = optimize_mesh(mesh.view, options.mesh_optimization);
+                            auto view = optimized.view();
+                            println("Optimized triangle mesh at index {}: {} -> {} vertices, {} -> {} triangles.", shape_index,
+                                    mesh.view.num_vertices, view.num_vertices, mesh.view.num_triangles, view.num_triangles);
+                            mesh = {.view = view};
+                            profiler.accumulate(optimize_mesh_stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                        }
+                        mesh_stats[shape_index] = MeshStats::of(mesh.view);
+                        auto start = std::chrono::steady_clock::now();
+                        if (sink != nullptr) {
+                            sink->on_mesh(exported_file, mesh.view);
+                            profiler.accumulate(export_mesh_stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                            return;
+                        }
+                        if (format == MeshFormat::PLY && !mesh.ply_file.empty()) {
+                            println("Copying binary PLY mesh at index {} to {}.", shape_index, path.filename().generic_string());
+                            std::filesystem::copy_file(mesh.ply_file, path, std::filesystem::copy_options::overwrite_existing);
+                        } else {
+                            println("Converting triangle mesh at index {} to {}.", shape_index, path.filename().generic_string());
+                            dump_mesh(path, mesh.view, format);
+                        }
+                        auto size = std::filesystem::file_size(path);
+                        profiler.add_bytes_written(size);
+                        profiler.accumulate(export_mesh_stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), size);
+                    });
+                    exported_files.emplace_back(exported_file, output_hash);
+                }
+                if (!placed) { break; }// the mesh may still be exported for other shapes
+                if (is_visible(base_shape) && visible_uses[exported_index] > 1u) {
+                    if (instanced_meshes.emplace(exported_index).second) {
+                        exported.write(luisa::format("Mesh:{}", exported_index),
+                                       {{"type", "Shape"},
+                                        {"impl", "Mesh"},
+                                        {"prop", {{"file", std::move(exported_file)}}}});
+                    }
+                    shape["impl"] = "Instance";
+                    prop["shape"] = luisa::format("@Mesh:{}", exported_index);
+                } else {
+                    shape["impl"] = "Mesh";
+                    prop["file"] = std::move(exported_file);
+                }
+                if (auto a = shape_alpha(base_shape); a != minipbrt::kInvalidIndex) {// override the material's alpha
+                    auto alpha_texture_name = resolved_name(texture_name(scene, a));
+                    if (auto m = base_shape->material; m == minipbrt::kInvalidIndex) {
                         auto alpha_surface_name = luisa::format("Alpha:{}", alpha_texture_name);
-                        if (!converted.contains(alpha_surface_name)) {
-                            converted[alpha_surface_name] = {
-                                {"type", "Surface"},
-                                {"impl", "Matte"},
-                                {"prop",
-                                 {{"alpha", luisa::format("@{}", alpha_texture_name)}}}};
+                        if (alpha_surfaces.emplace(alpha_surface_name).second) {
+                            exported.write(alpha_surface_name,
+                                           {{"type", "Surface"},
+                                            {"impl", "Matte"},
+                                            {"prop",
+                                             {{"alpha", luisa::format("@{}", alpha_texture_name)}}}});
                         }
                         prop["surface"] = luisa::format("@{}", alpha_surface_name);
                     } else {
-                        auto base_surface_name = material_name(scene, m);
+                        auto base_surface_name = resolved_name(material_name(scene, m));
                         auto alpha_surface_name = luisa::format("{}:Alpha:{}", base_surface_name, alpha_texture_name);
-                        if (!converted.contains(alpha_surface_name)) {
-                            auto s = converted[base_surface_name];
+                        if (alpha_surfaces.emplace(alpha_surface_name).second) {
+                            auto base_surface = graph.find(base_surface_name);
+                            expect(base_surface.has_value(), "Surface {} not found.", base_surface_name);
+                            auto s = graph.node(*base_surface);
                             s["prop"]["alpha"] = luisa::format("@{}", alpha_texture_name);
-                            converted[alpha_surface_name] = std::move(s);
+                            exported.write(alpha_surface_name, s);
                         }
                         prop["surface"] = luisa::format("@{}", alpha_surface_name);
                     }
                 }
+                if (!part_files.empty()) {// the parts carry the surface and light, the group the transform
+                    auto parts = nlohmann::json::array();
+                    for (auto part = 0u; part < part_files.size(); part++) {
+                        nlohmann::json part_shape{{"type", "Shape"},
+                                                  {"impl", "Mesh"},
+                                                  {"prop", {{"file", std::move(part_files[part])}}}};
+                        for (auto key : {"surface", "light"}) {
+                            if (auto iter = prop.find(key); iter != prop.end()) { part_shape["prop"][key] = *iter; }
+                        }
+                        auto part_name = luisa::format("Shape:{}:Part:{}", shape_index, part);
+                        exported.write(part_name, part_shape);
+                        parts.emplace_back(luisa::format("@{}", part_name));
+                    }
+                    shape["impl"] = "Group";
+                    prop.erase("file");
+                    prop.erase("surface");
+                    prop.erase("light");
+                    prop["shapes"] = std::move(parts);
+                }
                 break;
             }
             default: eprintln("Ignored unsupported shape at index {} with type '{}'.",
                               shape_index, magic_enum::enum_name(shape_type));
         }
-        if (shape.contains("impl")) {
-            converted[luisa::format("Shape:{}", shape_index)] = shape;
-            if (base_shape->object == minipbrt::kInvalidIndex) {// directly visible shape
-                converted["render"]["shapes"].emplace_back(luisa::format("@Shape:{}", shape_index));
+        if (shape.contains("impl") && placed) {
+            if (auto m = base_shape->material; m != minipbrt::kInvalidIndex) {
+                // under the name of the node kept in the exported scene, after merging
+                stats.add_material_use(resolved_name(material_name(scene, m)), placements(base_shape));
+            }
+            exported.write(luisa::format("Shape:{}", shape_index), shape);
+            if (is_visible(base_shape)) {// directly visible shape
+                render["shapes"].emplace_back(luisa::format("@Shape:{}", shape_index));
             }
         }
     }
     // process objects
     for (auto object_index = 0u; object_index < scene->objects.size(); object_index++) {
         auto base_object = scene->objects[object_index];
+        if (flattened_objects[object_index] != minipbrt::kInvalidIndex) {
+            println("Inlined object at index {} into instance at index {}.",
+                    object_index, flattened_objects[object_index]);
+            continue;
+        }
+        if (options.prune_unreferenced && object_uses[object_index] == 0u) {
+            println("Skipped object at index {} as no instance places it.", object_index);
+            continue;
+        }
         auto object = nlohmann::json::object();
         object["type"] = "Shape";
         object["impl"] = "Group";
         auto &prop = (object["prop"] = nlohmann::json::object());
         // transform
-        if (auto t = convert_transform(base_object->objectToInstance); !t.is_null()) {
+        if (auto t = convert_node_transform(base_object->objectToInstance); !t.is_null()) {
             prop["transform"] = std::move(t);
         }
         auto &shapes = (prop["shapes"] = nlohmann::json::array());
@@ -366,7 +831,7 @@ static void convert_shapes(
             for (auto s = 0u; s < base_object->numShapes; s++) {
                 shapes.emplace_back(luisa::format("@Shape:{}", base_object->firstShape + s));
             }
-            converted[luisa::format("Object:{}", object_index)] = object;
+            exported.write(luisa::format("Object:{}", object_index), object);
         }
     }
     // process instances
@@ -383,26 +848,42 @@ static void convert_shapes(
             if (base_instance->reverseOrientation) {
                 eprintln("Ignored unsupported instance reverse orientation at index {}.", instance_index);
             }
+            if (flattened_objects[o] == instance_index) { continue; }
             auto instance = nlohmann::json::object();
             instance["type"] = "Shape";
             instance["impl"] = "Instance";
             auto &prop = (instance["prop"] = nlohmann::json::object());
             // transform
-            if (auto t = convert_transform(base_instance->instanceToWorld); !t.is_null()) {
+            if (auto t = convert_node_transform(base_instance->instanceToWorld); !t.is_null()) {
                 prop["transform"] = std::move(t);
             }
             if (auto l = base_instance->areaLight; l != minipbrt::kInvalidIndex) {
                 prop["light"] = luisa::format("@AreaLight:{}", l);
             }
             prop["shape"] = luisa::format("@Object:{}", o);
-            converted[luisa::format("Instance:{}", instance_index)] = instance;
-            converted["render"]["shapes"].emplace_back(luisa::format("@Instance:{}", instance_index));
+            exported.write(luisa::format("Instance:{}", instance_index), instance);
+            render["shapes"].emplace_back(luisa::format("@Instance:{}", instance_index));
         }
     }
+    if (options.transform_table) {
+        auto scope = profiler.scope("write_transform_table");
+        auto path = base_dir / transform_table_file;
+        transform_table.write(path);
+        profiler.add_bytes_written(std::filesystem::file_size(path));
+        println("Wrote {} transforms to {}.", transform_table.size(), transform_table_file);
+    }
+    {
+        auto scope = profiler.scope("wait_for_mesh_export");
+        tasks.wait();
+    }
+    for (auto &&[file, hash] : exported_files) { cache.record(file, hash); }
+    for (auto &&[shape_index, files] : written_meshes) {
+        stats.add_mesh(std::move(files), mesh_stats[shape_index], mesh_placements[shape_index]);
+    }
 }
 
 static void convert_area_lights(const minipbrt::Scene *scene,
-                                nlohmann::json &converted) noexcept {
+                                SceneGraph &graph) {
     for (auto i = 0u; i < scene->areaLights.size(); i++) {
         auto base_light = scene->areaLights[i];
         expect(base_light->type() == minipbrt::AreaLightType::Diffuse,
@@ -420,13 +901,14 @@ static void convert_area_lights(const minipbrt::Scene *scene,
                                            base_light->scale[1] * diffuse->L[1],
                                            base_light->scale[2] * diffuse->L[2]})}}}};
         prop["two_sided"] = diffuse->twosided;
-        converted[luisa::format("AreaLight:{}", i)] = light;
+        graph.add(luisa::format("AreaLight:{}", i), std::move(light));
     }
 }
 
 static void convert_textures(const std::filesystem::path &base_dir,
                              const minipbrt::Scene *scene,
-                             nlohmann::json &converted) noexcept {
+                             SceneGraph &graph,
+                             TextureStager &textures) {
     for (auto texture_index = 0u; texture_index < scene->textures.size(); texture_index++) {
         auto base_texture = scene->textures[texture_index];
         nlohmann::json texture;
@@ -459,13 +941,8 @@ static void convert_textures(const std::filesystem::path &base_dir,
                 auto image = static_cast<const minipbrt::ImageMapTexture *>(base_texture);
                 expect(image->filename != nullptr, "Image filename is null.");
                 try {
-                    std::filesystem::path file{image->filename};
-                    if (!file.is_absolute()) { file = base_dir / file; }
-                    file = std::filesystem::canonical(file);
-                    auto copied_file = luisa::format("lr_exported_textures/{:05}_{}",
-                                                     texture_index, file.filename().generic_string());
-                    std::filesystem::create_directories(base_dir / "lr_exported_textures");
-                    std::filesystem::copy(file, base_dir / copied_file, std::filesystem::copy_options::update_existing);
+                    // copied in the background, once per source file
+                    auto copied_file = textures.stage(image->filename, luisa::format("{:05}_", texture_index));
                     texture["impl"] = "Image";
                     if (auto mapping = image->mapping; mapping == minipbrt::TexCoordMapping::UV) {
                         prop["uv_scale"] = {image->uscale, image->vscale};
@@ -487,7 +964,7 @@ static void convert_textures(const std::filesystem::path &base_dir,
                         prop["encoding"] = "sRGB";
                     }
                 } catch (const std::exception &e) {
-                    eprintln("Failed to copy image file: {}.", e.what());
+                    eprintln("Failed to resolve image file path: {}.", e.what());
                 }
                 break;
             }
@@ -498,14 +975,14 @@ static void convert_textures(const std::filesystem::path &base_dir,
                 break;
             }
         }
-        converted[texture_name(scene, texture_index)] = texture;
+        graph.add(texture_name(scene, texture_index), std::move(texture));
     }
 }
 
 [[nodiscard]] static void convert_bump_to_normal(const std::filesystem::path &base_dir,
                                                  const minipbrt::Scene *scene,
                                                  uint32_t bump_map_index,
-                                                 nlohmann::json &prop) noexcept {
+                                                 nlohmann::json &prop) {
     prop["normal_map"] = nlohmann::json::object(
         {{"type", "Texture"},
          {"impl", "BumpToNormal"},
@@ -531,7 +1008,7 @@ static void convert_textures(const std::filesystem::path &base_dir,
 
 static void convert_materials(const std::filesystem::path &base_dir,
                               const minipbrt::Scene *scene,
-                              nlohmann::json &converted) noexcept {
+                              SceneGraph &graph) {
     for (auto i = 0u; i < scene->materials.size(); i++) {
         auto base_material = scene->materials[i];
         auto material = nlohmann::json::object();
@@ -701,12 +1178,11 @@ static void convert_materials(const std::filesystem::path &base_dir,
                 break;
             }
         }
-        auto name = material_name(scene, i);
-        converted[name] = material;
+        graph.add(material_name(scene, i), std::move(material));
     }
 }
 
-[[nodiscard]] static nlohmann::json convert_film(const minipbrt::Film *base_film) noexcept {
+[[nodiscard]] static nlohmann::json convert_film(const minipbrt::Film *base_film) {
     expect(base_film->type() == minipbrt::FilmType::Image,
            "Unsupported film type {}.", magic_enum::enum_name(base_film->type()));
     auto image = static_cast<const minipbrt::ImageFilm *>(base_film);
@@ -727,7 +1203,7 @@ static void convert_materials(const std::filesystem::path &base_dir,
 }
 
 static void convert_camera(const minipbrt::Scene *scene,
-                           nlohmann::json &converted) noexcept {
+                           nlohmann::json &render) {
     auto base_camera = scene->camera;
     expect(base_camera->type() == minipbrt::CameraType::Perspective,
            "Unsupported camera type {}.", magic_enum::enum_name(base_camera->type()));
@@ -771,31 +1247,65 @@ static void convert_camera(const minipbrt::Scene *scene,
         return "render.exr";
     }();
     prop["spp"] = 1024;
-    converted["render"]["cameras"] = nlohmann::json::array({camera});
+    render["cameras"] = nlohmann::json::array({camera});
 }
 
+// the strings in the nodes that may refer to image files, i.e., all but the shapes, that are left in the graph
+[[nodiscard]] static std::unordered_set<std::string> collect_file_references(const SceneGraph &graph) {
+    std::unordered_set<std::string> strings;
+    auto collect = [&strings](auto &self, const nlohmann::json &value) -> void {
+        if (auto s = value.get_ptr<const std::string *>()) {
+            strings.emplace(*s);
+        } else if (value.is_structured()) {
+            for (auto &&v : value) { self(self, v); }
+        }
+    };
+    for (auto kind : {NodeKind::Texture, NodeKind::Surface, NodeKind::Light, NodeKind::Environment}) {
+        for (auto node : graph.nodes(kind)) {
+            if (!graph.removed(node)) { collect(collect, graph.node(node)); }
+        }
+    }
+    return strings;
+}
+
+// finishes <name>.exported.* with the group of the rendered shapes and writes the scene files importing it
 static void dump_converted_scene(const std::filesystem::path &base_dir,
                                  std::string_view name,
-                                 nlohmann::json converted) noexcept {
-    auto render = std::move(converted["render"]);
-    converted.erase("render");
+                                 SceneWriter &exported,
+                                 SceneSink *sink,
+                                 nlohmann::json render,
+                                 const SceneStats &stats,
+                                 ConversionCache &cache,
+                                 Profiler &profiler) {
     auto shapes = std::move(render["shapes"]);
     render.erase("shapes");
-    converted["renderable"] = {
-        {"type", "Shape"},
-        {"impl", "Group"},
-        {"prop", {{"shapes", std::move(shapes)}}}};
+    exported.write("renderable",
+                   {{"type", "Shape"},
+                    {"impl", "Group"},
+                    {"prop", {{"shapes", std::move(shapes)}}}});
     render["shapes"] = nlohmann::json::array({"@renderable"});
+    println("Scene cost: {} unique and {} instanced triangles, {} bytes of geometry and {} bytes of textures.",
+            stats.unique_triangles(), stats.instanced_triangles(), stats.geometry_bytes(), stats.texture_bytes());
+    exported.finish(cache);
+    profiler.add_bytes_written(exported.bytes_written());
+    auto format = exported.format();
+    auto extension = scene_format_extension(format);
+    auto exported_file = exported.file_name();
+    if (sink != nullptr) {
+        sink->on_finish(render, stats.report());
+        return;
+    }
     nlohmann::json entry = {
         {"render", std::move(render)},
-        {"import", nlohmann::json::array({luisa::format("{}.exported.json", name)})},
+        {"import", nlohmann::json::array({std::move(exported_file)})},
     };
-    auto write_json = [&base_dir](std::string_view file_name, const nlohmann::json &json) {
-        std::ofstream f{base_dir / file_name};
-        f << json.dump(4);
+    auto write_scene_file = [&base_dir, &cache, &profiler, format](std::string file_name, const nlohmann::json &json) {
+        SceneWriter writer{base_dir, std::move(file_name), format};
+        for (auto &&[key, value] : json.items()) { writer.write(key, value); }
+        writer.finish(cache);
+        profiler.add_bytes_written(writer.bytes_written());
     };
-    write_json(luisa::format("{}.exported.json", name), converted);
-    write_json(luisa::format("{}.json", name), entry);
+    write_scene_file(luisa::format("{}.{}", name, extension), entry);
     // also make a interactive display version of the scene file
     for (auto &camera : entry["render"]["cameras"]) {
         auto film = std::move(camera["prop"]["film"]);
@@ -804,12 +1314,17 @@ static void dump_converted_scene(const std::filesystem::path &base_dir,
             {"prop", {{"base", std::move(film)}, {"tonemapping", "AgX"}}}};
         camera["prop"]["spp"] = 65536;
     }
-    write_json(luisa::format("{}.display.json", name), entry);
+    write_scene_file(luisa::format("{}.display.{}", name, extension), entry);
+    auto stats_file = base_dir / luisa::format("{}.stats.json", name);
+    stats.save_report(stats_file);
+    profiler.add_bytes_written(std::filesystem::file_size(stats_file));
 }
 
 static void convert_lights(const std::filesystem::path &base_dir,
                            const minipbrt::Scene *scene,
-                           nlohmann::json &converted) {
+                           SceneGraph &graph,
+                           nlohmann::json &render,
+                           TextureStager &textures) {
     std::vector<std::string> env_array;
     for (auto light_index = 0u; light_index < scene->lights.size(); light_index++) {
         auto base_light = scene->lights[light_index];
@@ -860,8 +1375,8 @@ static void convert_lights(const std::filesystem::path &base_dir,
                 }
                 prop["light"] = light;
                 //                converted[luisa::format("Light:{}", light_index)] = light;
-                converted[luisa::format("PointLight:{}", light_index)] = light_shape;
-                converted["render"]["shapes"].emplace_back(luisa::format("@PointLight:{}", light_index));
+                graph.add(luisa::format("PointLight:{}", light_index), std::move(light_shape));
+                render["shapes"].emplace_back(luisa::format("@PointLight:{}", light_index));
                 break;
             }
             case minipbrt::LightType::Distant: {
@@ -903,7 +1418,7 @@ static void convert_lights(const std::filesystem::path &base_dir,
                             {"prop", {{"base", std::move(base_emission)}, {"scale", {scale[0], scale[1], scale[2]}}}}};
                     }
                     auto name = luisa::format("Env:{}:Directional", light_index);
-                    converted[name] = env;
+                    graph.add(name, std::move(env));
                     env_array.emplace_back("@" + name);
                 }
                 break;
@@ -916,23 +1431,13 @@ static void convert_lights(const std::filesystem::path &base_dir,
                 auto &prop = (env["prop"] = nlohmann::json::object());
                 auto &e = (prop["emission"] = nlohmann::json::object());
                 if (auto map = infinite_light->mapname) {
-                    auto file = [&base_dir, map] {
+                    auto copied_file = [&textures, map, light_index] {
                         try {
-                            std::filesystem::path file{map};
-                            if (!file.is_absolute()) { file = base_dir / file; }
-                            return std::filesystem::canonical(file);
+                            return textures.stage(map, luisa::format("env_{:05}_", light_index));
                         } catch (const std::exception &ex) {
                             panic("Failed to resolve image file path: {}.", ex.what());
                         }
                     }();
-                    auto copied_file = luisa::format("lr_exported_textures/env_{:05}_{}",
-                                                     light_index, file.filename().generic_string());
-                    try {
-                        std::filesystem::create_directories(base_dir / "lr_exported_textures");
-                        std::filesystem::copy(file, base_dir / copied_file, std::filesystem::copy_options::update_existing);
-                    } catch (const std::exception &ex) {
-                        panic("Failed to copy image file: {}.", ex.what());
-                    }
                     e["impl"] = "Image";
                     e["prop"] = {{"file", copied_file}};
                 } else {
@@ -953,7 +1458,7 @@ static void convert_lights(const std::filesystem::path &base_dir,
                 }
                 auto name = luisa::format("Env:{}:Spherical", light_index);
                 prop["transform"] = convert_envmap_transform(base_light->lightToWorld);
-                converted[name] = env;
+                graph.add(name, std::move(env));
                 env_array.emplace_back("@" + name);
                 break;
             }
@@ -963,68 +1468,193 @@ static void convert_lights(const std::filesystem::path &base_dir,
     }
     println("Environment count: {}", env_array.size());
     if (env_array.size() == 1u) {
-        converted["render"]["environment"] = env_array[0];
+        render["environment"] = env_array[0];
     } else if (env_array.size() > 1u) {
-        converted["render"]["environment"] = nlohmann::json::object({{"type", "Environment"}, {"impl", "Grouped"}, {"prop", {{"environments", nlohmann::json::array()}}}});
+        render["environment"] = nlohmann::json::object({{"type", "Environment"}, {"impl", "Grouped"}, {"prop", {{"environments", nlohmann::json::array()}}}});
         for (auto &item : env_array) {
-            converted["render"]["environment"]["prop"]["environments"].emplace_back(item);
+            render["environment"]["prop"]["environments"].emplace_back(item);
         }
     }
 }
 
 static void convert_scene(const std::filesystem::path &source_path,
-                          const minipbrt::Scene *scene) noexcept {
+                          const minipbrt::Scene *scene,
+                          const ConvertOptions &options,
+                          ThreadPool &pool,
+                          Profiler &profiler,
+                          SceneSink *sink) {
     try {
         println("Time: {} -> {}", scene->startTime, scene->endTime);
         println("Medium count: {}", scene->mediums.size());
         auto base_dir = source_path.parent_path();
-        nlohmann::json converted{
-            {"render",
-             {{"integrator",
-               {{"impl", "MegaPath"},
-                {"prop",
-                 {{"depth", 10},
-                  {"rr_depth", 2},
-                  {"sampler", {{"impl", "PMJ02BN"}}}}}}},
-              {"shapes", nlohmann::json::array()}}}};
-        convert_textures(base_dir, scene, converted);
-        convert_materials(base_dir, scene, converted);
-        convert_area_lights(scene, converted);
+        nlohmann::json render{
+            {"integrator",
+             {{"impl", "MegaPath"},
+              {"prop",
+               {{"depth", 10},
+                {"rr_depth", 2},
+                {"sampler", {{"impl", "PMJ02BN"}}}}}}},
+            {"shapes", nlohmann::json::array()}};
         auto name = source_path.stem().generic_string();
-        convert_shapes(base_dir, scene, name, converted);
-        convert_lights(base_dir, scene, converted);
-        convert_camera(scene, converted);
-        dump_converted_scene(base_dir, name, std::move(converted));
+        ConversionCache cache{base_dir, name, options.incremental};
+        // the outputs are overwritten, so a manifest of an incremental run would not match them
+        if (!options.incremental && sink == nullptr) { cache.remove_manifest(); }
+        // the textures, surfaces and lights are gathered in the graph for the passes, then
+        // serialized to <name>.exported.*, or the sink, ahead of the streamed shapes
+        SceneGraph graph;
+        // image files are copied on the pool, once it is known which ones the scene keeps
+        TextureStager textures{base_dir, cache, profiler, pool, options.link_textures, sink != nullptr};
+        SceneStats stats;
+        // runs a pass in its own profiler stage
+        auto stage = [&profiler](std::string stage_name, auto &&pass) {
+            auto scope = profiler.scope(std::move(stage_name));
+            pass();
+        };
+        stage("convert_textures", [&] { convert_textures(base_dir, scene, graph, textures); });
+        stage("convert_materials", [&] { convert_materials(base_dir, scene, graph); });
+        stage("convert_area_lights", [&] { convert_area_lights(scene, graph); });
+        stage("convert_lights", [&] { convert_lights(base_dir, scene, graph, render, textures); });
+        stage("convert_camera", [&] { convert_camera(scene, render); });
+        // The passes run before the shapes are converted, with the shapes' references taken from
+        // the scene, so that the texture copies overlap the mesh export. Textures are folded
+        // first, as those folded to the same constants can be merged, and merged before
+        // pruning, as both leave textures unreferenced.
+        if (options.fold_constant_textures) {
+            stage("fold_constant_textures", [&] {
+                auto folded = fold_constant_textures(graph);
+                println("Folded {} constant texture expressions.", folded);
+            });
+        }
+        if (options.deduplicate_materials) {
+            stage("merge_identical_nodes", [&] {
+                auto merged = merge_identical_nodes(graph);
+                println("Merged {} identical surface and texture nodes.", merged);
+            });
+        }
+        if (options.prune_unreferenced) {
+            stage("remove_unreachable_nodes", [&] {
+                auto roots = collect_shape_references(scene);
+                roots.emplace_back(render);
+                auto removed = remove_unreachable_nodes(graph, roots);
+                println("Removed {} unreferenced nodes.", removed);
+                auto files = collect_file_references(graph);
+                textures.dispatch(&files);
+            });
+        } else {
+            textures.dispatch();
+        }
+        auto exported_file = luisa::format("{}.exported.{}", name, scene_format_extension(options.scene_format));
+        auto exported = sink == nullptr ?
+                            std::make_unique<SceneWriter>(base_dir, exported_file, options.scene_format) :
+                            std::make_unique<SceneWriter>(*sink, exported_file);
+        stage("serialize_scene_graph", [&] { graph.serialize(*exported); });
+        stage("convert_shapes", [&] { convert_shapes(base_dir, scene, name, graph, *exported, sink, render, stats, options, cache, pool, profiler); });
+        stats.set_textures(textures.dispatched_count(), textures.dispatched_bytes());
+        stage("dump_converted_scene", [&] { dump_converted_scene(base_dir, name, *exported, sink, std::move(render), stats, cache, profiler); });
+        stage("wait_for_texture_copies", [&] { textures.wait(); });
+        cache.save();
     } catch (const std::exception &e) {
         luisa::panic("{}", e.what());
     }
 }
 
-void convert(const char *scene_file_name) noexcept {
+SceneSource SceneSource::from_file(std::filesystem::path file) noexcept {
+    return {.file = std::move(file)};
+}
+
+SceneSource SceneSource::from_text(std::string text, std::filesystem::path base_dir, std::string name) noexcept {
+    return {.text = std::move(text), .base_dir = std::move(base_dir), .name = std::move(name)};
+}
+
+// loads the scene and converts it to the files next to it, or to `sink` if not null
+static void convert_source(const SceneSource &source, const ConvertOptions &options,
+                           ThreadPool &pool, SceneSink *sink) {
+    auto from_file = !source.file.empty();
+    auto scene_file = from_file ?
+                          std::filesystem::canonical(source.file) :
+                          std::filesystem::absolute(source.base_dir) / luisa::format("{}.pbrt", source.name);
+    // batch mode turns the reports off, as the peak RSS of concurrent scenes would mix
+    Profiler profiler{options.profile || !options.profile_report.empty(), options.profile_reset_peak_rss};
+    minipbrt::Loader loader;
+    auto loaded = [&] {
+        auto scope = profiler.scope("loader.load");
+        return from_file ? loader.load(scene_file.generic_string().c_str()) :
+                           loader.load_from_memory(source.text.data(), source.text.size());
+    }();
+    if (loaded) {
+        // Nurbs, LoopSubdiv, HeightField and PLYMesh shapes are triangulated
+        // on demand in convert_shapes, so they are never all resident at once
+        convert_scene(scene_file, loader.borrow_scene(), options, pool, profiler, sink);
+        if (options.profile) { profiler.print_summary(); }
+        if (!options.profile_report.empty()) { profiler.save_report(options.profile_report); }
+    } else {
+        auto e = loader.error();
+        auto message = e ? luisa::format("{} [{}:{}:{}]",
+                                         e->message(), e->filename(), e->line(), e->column()) :
+                           "unknown";
+        luisa::panic("Failed to load scene file {}: {}", scene_file.generic_string(), message);
+    }
+}
+
+void convert(const char *scene_file_name, const ConvertOptions &options, ThreadPool &pool) {
     try {
-        auto scene_file = std::filesystem::canonical(scene_file_name);
-        minipbrt::Loader loader;
-        if (loader.load(scene_file.generic_string().c_str())) {
-            minipbrt::Bits<minipbrt::ShapeType> shape_types;
-            shape_types.set(minipbrt::ShapeType::Nurbs);
-            shape_types.set(minipbrt::ShapeType::LoopSubdiv);
-            shape_types.set(minipbrt::ShapeType::HeightField);
-            shape_types.set(minipbrt::ShapeType::PLYMesh);
-            if (loader.borrow_scene()->shapes_to_triangle_mesh(shape_types)) {
-                convert_scene(scene_file, loader.borrow_scene());
-            } else {
-                luisa::panic("Failed to load all PLY meshes");
-            }
-        } else {
-            auto e = loader.error();
-            auto message = e ? luisa::format("{} [{}:{}:{}]",
-                                             e->message(), e->filename(), e->line(), e->column()) :
-                               "unknown";
-            luisa::panic("Failed to load scene file {}: {}", scene_file.generic_string(), message);
-        }
+        convert_source(SceneSource::from_file(scene_file_name), options, pool, nullptr);
     } catch (const std::exception &e) {
         luisa::panic("{}", e.what());
     }
 }
 
-}// namespace luisa::render
\ No newline at end of file
+void convert(const char *scene_file_name, const ConvertOptions &options) {
+    ThreadPool pool{options.jobs};
+    convert(scene_file_name, options, pool);
+}
+
+std::expected<void, std::string> convert(const SceneSource &source, SceneSink &sink,
+                                         const ConvertOptions &options, ThreadPool &pool) noexcept {
+    // the options that only concern the files written next to the scene are turned off
+    auto in_process = options;
+    in_process.incremental = false;
+    in_process.stream_ply = false;
+    in_process.split_meshes_above = 0u;
+    in_process.transform_table = false;
+    in_process.link_textures = false;
+    try {
+        convert_source(source, in_process, pool, &sink);
+        return {};
+    } catch (const std::exception &e) {
+        return std::unexpected{std::string{e.what()}};
+    } catch (...) {
+        return std::unexpected{std::string{"unknown error"}};
+    }
+}
+
+std::expected<void, std::string> convert(const SceneSource &source, SceneSink &sink,
+                                         const ConvertOptions &options) noexcept {
+    try {
+        ThreadPool pool{options.jobs};
+        return convert(source, sink, options, pool);
+    } catch (const std::exception &e) {
+        return std::unexpected{std::string{e.what()}};
+    }
+}
+
+std::expected<ConvertedScene, std::string> convert_to_memory(const SceneSource &source,
+                                                             const ConvertOptions &options,
+                                                             ThreadPool &pool) noexcept {
+    MemorySceneSink sink;
+    if (auto result = convert(source, sink, options, pool); !result) {
+        return std::unexpected{std::move(result.error())};
+    }
+    return sink.take();
+}
+
+std::expected<ConvertedScene, std::string> convert_to_memory(const SceneSource &source,
+                                                             const ConvertOptions &options) noexcept {
+    MemorySceneSink sink;
+    if (auto result = convert(source, sink, options); !result) {
+        return std::unexpected{std::move(result.error())};
+    }
+    return sink.take();
+}
+
+}// namespace luisa::render
@@ -2,6 +2,107 @@
 // Created by Mike on 2024/4/16.
 //
 
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+
+#include "thread_pool.h"
+#include "mesh_writer.h"
+#include "mesh_optimizer.h"
+#include "scene_writer.h"
+#include "scene_sink.h"
+
 namespace luisa::render {
-void convert(const char *scene_file_name) noexcept;
+
+struct ConvertOptions {
+    // number of worker threads for mesh export, 0 for hardware concurrency
+    uint32_t jobs{0u};
+    // file format of the exported meshes
+    MeshFormat mesh_format{MeshFormat::OBJ};
+    // file format of <name>.exported.*, <name>.* and <name>.display.*
+    SceneFormat scene_format{SceneFormat::JSON};
+    // export byte-identical triangle meshes only once and share the file
+    bool deduplicate_meshes{true};
+    // evaluate the textures computed from constants only, see fold_constant_textures()
+    bool fold_constant_textures{true};
+    // merge identical surfaces and textures into one node each, see merge_identical_nodes()
+    bool deduplicate_materials{true};
+    // leave out the nodes that no rendered shape, light or camera refers to, see
+    // remove_unreachable_nodes(), and skip the meshes and image files only they use
+    bool prune_unreferenced{true};
+    // weld, clean up and reorder the triangle meshes before writing them, see optimize_mesh()
+    bool optimize_meshes{false};
+    MeshOptimizeOptions mesh_optimization;
+    // write meshes shared by several shapes outside objects once and place them
+    // with Instance nodes; implies deduplicate_meshes
+    bool auto_instance{false};
+    // inline objects used by a single instance into it if they consist of triangle
+    // meshes with at most this many triangles in total; 0 keeps all objects
+    uint32_t flatten_objects_below{0u};
+    // write the transforms of shapes, objects and instances into one binary table
+    // (<scene>.exported.transforms.bin) that the nodes refer to by index
+    bool transform_table{false};
+    // skip rewriting meshes, textures and scene files whose inputs are unchanged
+    // since the last run, as recorded in <name>.manifest.json
+    bool incremental{false};
+    // read binary PLY meshes through memory mappings instead of loading them
+    // into heap buffers, copying them verbatim when exporting to PLY
+    bool mmap_ply{false};
+    // read binary PLY meshes in chunks while exporting them, so that meshes larger than
+    // memory can be converted; streamed meshes are neither deduplicated nor optimized
+    bool stream_ply{false};
+    // split streamed meshes with more triangles than this into spatially coherent
+    // parts of about this size, grouped by a Group node; 0 keeps them whole
+    uint32_t split_meshes_above{0u};
+    // hard-link the exported image files to their sources where possible instead of
+    // copying them; the exported scene then shares the files with the source scene
+    bool link_textures{false};
+    // print the time, bytes written and peak memory of each conversion stage
+    bool profile{false};
+    // if not empty, also write the per-stage profile to this JSON file
+    std::filesystem::path profile_report;
+    // Reset the peak RSS of the process (VmHWM, Linux only) as each profiled stage
+    // starts, so that the profile shows the peak of each stage rather than of the
+    // process so far. The reset is visible to anything else measuring the process,
+    // so only the command line front end sets it; embedders get the peaks since start.
+    bool profile_reset_peak_rss{false};
+};
+
+// Both throw luisa::Error if the scene cannot be converted. The first overload
+// exports the meshes on the given pool, which may be shared by conversions
+// running concurrently; options.jobs is ignored then.
+void convert(const char *scene_file_name, const ConvertOptions &options, luisa::ThreadPool &pool);
+void convert(const char *scene_file_name, const ConvertOptions &options = {});
+
+// A pbrt scene to convert in process: a file, or text in memory whose relative
+// paths are resolved against base_dir and whose meshes are named after `name`.
+struct SceneSource {
+    std::filesystem::path file;
+    std::string text;
+    std::filesystem::path base_dir;
+    std::string name;
+    [[nodiscard]] static SceneSource from_file(std::filesystem::path file) noexcept;
+    [[nodiscard]] static SceneSource from_text(std::string text, std::filesystem::path base_dir,
+                                               std::string name = "scene") noexcept;
+};
+
+// Convert a scene in process, handing the nodes and meshes to `sink` as they
+// are produced, or gathering them into a ConvertedScene. Nothing is written to
+// disk: image textures refer to their source files, and the options concerning
+// output files only (incremental, stream_ply, split_meshes_above, transform_table
+// and link_textures) are ignored. Errors are returned rather
+// than thrown, with the sink left holding whatever was converted before.
+[[nodiscard]] std::expected<void, std::string> convert(const SceneSource &source, SceneSink &sink,
+                                                       const ConvertOptions &options, luisa::ThreadPool &pool) noexcept;
+[[nodiscard]] std::expected<void, std::string> convert(const SceneSource &source, SceneSink &sink,
+                                                       const ConvertOptions &options = {}) noexcept;
+[[nodiscard]] std::expected<ConvertedScene, std::string> convert_to_memory(const SceneSource &source,
+                                                                           const ConvertOptions &options,
+                                                                           luisa::ThreadPool &pool) noexcept;
+[[nodiscard]] std::expected<ConvertedScene, std::string> convert_to_memory(const SceneSource &source,
+                                                                           const ConvertOptions &options = {}) noexcept;
+
 }// namespace luisa::render
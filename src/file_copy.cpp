@@ -0,0 +1,133 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#elif defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+
+#include "logging.h"
+#include "file_copy.h"
+
+namespace luisa {
+
+#if defined(__linux__)
+
+namespace {
+
+class FileDescriptor {
+
+private:
+    int _fd;
+
+public:
+    explicit FileDescriptor(int fd) noexcept : _fd{fd} {}
+    ~FileDescriptor() noexcept {
+        if (_fd != -1) { ::close(_fd); }
+    }
+    FileDescriptor(FileDescriptor &&) noexcept = delete;
+    FileDescriptor(const FileDescriptor &) noexcept = delete;
+    [[nodiscard]] auto get() const noexcept { return _fd; }
+    [[nodiscard]] explicit operator bool() const noexcept { return _fd != -1; }
+};
+
+}// namespace
+
+[[nodiscard]] static FileCopyMethod copy_file_contents(const std::filesystem::path &src,
+                                                       const std::filesystem::path &dst) {
+    FileDescriptor in{::open(src.c_str(), O_RDONLY | O_CLOEXEC)};
+    expect(static_cast<bool>(in), "Failed to open {}: {}.", src.generic_string(), std::strerror(errno));
+    struct stat s {};
+    expect(::fstat(in.get(), &s) == 0, "Failed to stat {}: {}.", src.generic_string(), std::strerror(errno));
+    FileDescriptor out{::open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+    expect(static_cast<bool>(out), "Failed to create {}: {}.", dst.generic_string(), std::strerror(errno));
+    if (::ioctl(out.get(), FICLONE, in.get()) == 0) { return FileCopyMethod::Clone; }
+    auto remaining = static_cast<size_t>(s.st_size);
+    auto method = FileCopyMethod::KernelCopy;
+    while (remaining != 0u) {
+        auto n = ::copy_file_range(in.get(), nullptr, out.get(), nullptr, remaining, 0u);
+        if (n > 0) {
+            remaining -= static_cast<size_t>(n);
+            continue;
+        }
+        if (n == 0) { break; }// the source shrank
+        // not supported between these file systems or by this kernel
+        expect(remaining == static_cast<size_t>(s.st_size) &&
+                   (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL),
+               "Failed to copy {} to {}: {}.", src.generic_string(), dst.generic_string(), std::strerror(errno));
+        method = FileCopyMethod::StreamCopy;
+        break;
+    }
+    if (method == FileCopyMethod::StreamCopy) {
+        constexpr auto buffer_size = static_cast<size_t>(1024u * 1024u);
+        auto buffer = std::make_unique<char[]>(buffer_size);
+        for (;;) {
+            auto n = ::read(in.get(), buffer.get(), buffer_size);
+            if (n == 0) { break; }
+            if (n < 0 && errno == EINTR) { continue; }
+            expect(n > 0, "Failed to read {}: {}.", src.generic_string(), std::strerror(errno));
+            for (auto written = static_cast<ssize_t>(0); written < n;) {
+                auto m = ::write(out.get(), buffer.get() + written, static_cast<size_t>(n - written));
+                if (m < 0 && errno == EINTR) { continue; }
+                expect(m > 0, "Failed to write {}: {}.", dst.generic_string(), std::strerror(errno));
+                written += m;
+            }
+        }
+    }
+    return method;
+}
+
+#elif defined(__APPLE__)
+
+[[nodiscard]] static FileCopyMethod copy_file_contents(const std::filesystem::path &src,
+                                                       const std::filesystem::path &dst) {
+    if (::clonefile(src.c_str(), dst.c_str(), 0) == 0) { return FileCopyMethod::Clone; }
+    std::filesystem::copy_file(src, dst, std::filesystem::copy_options::overwrite_existing);
+    return FileCopyMethod::StreamCopy;
+}
+
+#else
+
+[[nodiscard]] static FileCopyMethod copy_file_contents(const std::filesystem::path &src,
+                                                       const std::filesystem::path &dst) {
+    // CopyFileW, which clones blocks on ReFS by itself
+    std::filesystem::copy_file(src, dst, std::filesystem::copy_options::overwrite_existing);
+    return FileCopyMethod::StreamCopy;
+}
+
+#endif
+
+FileCopyMethod copy_file_fast(const std::filesystem::path &src,
+                              const std::filesystem::path &dst,
+                              bool allow_hard_link) {
+    std::error_code ec;
+    if (std::filesystem::equivalent(src, dst, ec)) {
+        // already a hard link, or the very same path, which must not be removed below
+        if (allow_hard_link || std::filesystem::weakly_canonical(dst) == std::filesystem::weakly_canonical(src)) {
+            return FileCopyMethod::HardLink;
+        }
+    }
+    // never write through an existing name, which may be a hard link to the source
+    std::filesystem::remove(dst, ec);
+    expect(!ec, "Failed to replace {}: {}.", dst.generic_string(), ec.message());
+    if (allow_hard_link) {
+        std::filesystem::create_hard_link(src, dst, ec);
+        if (!ec) { return FileCopyMethod::HardLink; }
+    }
+    try {
+        return copy_file_contents(src, dst);
+    } catch (const std::filesystem::filesystem_error &e) {
+        panic("Failed to copy {} to {}: {}.", src.generic_string(), dst.generic_string(), e.what());
+    }
+}
+
+}// namespace luisa
@@ -0,0 +1,26 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+namespace luisa {
+
+enum struct FileCopyMethod : uint8_t {
+    HardLink,  // dst is another name of src
+    Clone,     // copy-on-write clone sharing the extents of src
+    KernelCopy,// copied inside the kernel, possibly offloaded to the file system
+    StreamCopy,// read and written through user space
+};
+
+// Copies src to dst, replacing dst, with the cheapest method the platform and
+// the file system support. Hard links are only made if allowed, since writes
+// through either name are then seen through both. Throws luisa::Error on failure.
+FileCopyMethod copy_file_fast(const std::filesystem::path &src,
+                              const std::filesystem::path &dst,
+                              bool allow_hard_link);
+
+}// namespace luisa
@@ -0,0 +1,45 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace luisa {
+
+// MurmurHash64A by Austin Appleby (public domain), used for content hashing
+[[nodiscard]] inline uint64_t hash64(const void *data, size_t size, uint64_t seed = 0u) noexcept {
+    constexpr auto m = 0xc6a4a7935bd1e995ull;
+    constexpr auto r = 47;
+    auto h = seed ^ (size * m);
+    auto p = static_cast<const std::byte *>(data);
+    auto end = p + (size & ~static_cast<size_t>(7u));
+    for (; p != end; p += 8) {
+        uint64_t k;
+        std::memcpy(&k, p, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    if (auto tail = size & 7u) {
+        uint64_t k = 0u;
+        std::memcpy(&k, p, tail);
+        h ^= k;
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+[[nodiscard]] inline uint64_t hash64(std::string_view s, uint64_t seed = 0u) noexcept {
+    return hash64(s.data(), s.size(), seed);
+}
+
+}// namespace luisa
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <stdexcept>
 #include <fmt/format.h>
 
 namespace luisa {
@@ -33,14 +34,20 @@ void eprintln(fmt::format_string<Args...> fmt, Args &&...args) noexcept {
     fmt::println(stderr, fmt, std::forward<Args>(args)...);
 }
 
+// thrown by panic() and expect(), so that a failed conversion can be reported
+// without taking down the other conversions running in the same process
+class Error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
 template<typename... Args>
-[[noreturn]] void panic(fmt::format_string<Args...> fmt, Args &&...args) noexcept {
-    eprintln(fmt, std::forward<Args>(args)...);
-    std::exit(EXIT_FAILURE);
+[[noreturn]] void panic(fmt::format_string<Args...> fmt, Args &&...args) {
+    throw Error{luisa::format(fmt, std::forward<Args>(args)...)};
 }
 
 template<typename... Args>
-void expect(bool condition, fmt::format_string<Args...> fmt, Args &&...args) noexcept {
+void expect(bool condition, fmt::format_string<Args...> fmt, Args &&...args) {
     if (!condition) { panic(fmt, std::forward<Args>(args)...); }
 }
 
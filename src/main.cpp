@@ -1,11 +1,165 @@
+#include <vector>
+#include <charconv>
+#include <filesystem>
+#include <string_view>
+
 #include "logging.h"
 #include "convert.h"
+#include "batch.h"
+
+[[nodiscard]] static uint32_t parse_uint(std::string_view option, std::string_view value) {
+    auto x = 0u;
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), x);
+    luisa::expect(ec == std::errc{} && end == value.data() + value.size(),
+                  "Invalid value '{}' for option '{}'.", value, option);
+    return x;
+}
+
+[[nodiscard]] static float parse_float(std::string_view option, std::string_view value) {
+    auto x = 0.f;
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), x);
+    luisa::expect(ec == std::errc{} && end == value.data() + value.size() && x >= 0.f,
+                  "Invalid value '{}' for option '{}'.", value, option);
+    return x;
+}
+
+static int run(int argc, char *argv[]) {
+    luisa::render::ConvertOptions options;
+    // the process is ours, so the profile may reset its peak RSS per stage
+    options.profile_reset_peak_rss = true;
+    std::vector<std::filesystem::path> inputs;
+    auto batch = false;
+    std::filesystem::path batch_summary;
+    for (auto i = 1; i < argc; i++) {
+        std::string_view arg{argv[i]};
+        auto value = [&] {
+            luisa::expect(i + 1 < argc, "Missing value for option '{}'.", arg);
+            return std::string_view{argv[++i]};
+        };
+        if (arg == "-j" || arg == "--jobs") {
+            options.jobs = parse_uint(arg, value());
+        } else if (arg == "--mesh-format") {
+            if (auto f = value(); f == "obj") {
+                options.mesh_format = luisa::render::MeshFormat::OBJ;
+            } else if (f == "ply") {
+                options.mesh_format = luisa::render::MeshFormat::PLY;
+            } else {
+                luisa::panic("Invalid value '{}' for option '{}'.", f, arg);
+            }
+        } else if (arg == "--compact") {
+            options.scene_format = luisa::render::SceneFormat::CompactJSON;
+        } else if (arg == "--scene-format") {
+            if (auto f = value(); f == "json") {
+                options.scene_format = luisa::render::SceneFormat::JSON;
+            } else if (f == "compact") {
+                options.scene_format = luisa::render::SceneFormat::CompactJSON;
+            } else if (f == "cbor") {
+                options.scene_format = luisa::render::SceneFormat::CBOR;
+            } else if (f == "msgpack") {
+                options.scene_format = luisa::render::SceneFormat::MessagePack;
+            } else if (f == "ubjson") {
+                options.scene_format = luisa::render::SceneFormat::UBJSON;
+            } else {
+                luisa::panic("Invalid value '{}' for option '{}'.", f, arg);
+            }
+        } else if (arg == "--no-mesh-dedup") {
+            options.deduplicate_meshes = false;
+        } else if (arg == "--no-texture-folding") {
+            options.fold_constant_textures = false;
+        } else if (arg == "--no-material-dedup") {
+            options.deduplicate_materials = false;
+        } else if (arg == "--keep-unreferenced") {
+            options.prune_unreferenced = false;
+        } else if (arg == "--optimize-meshes") {
+            options.optimize_meshes = true;
+        } else if (arg == "--weld-epsilon") {
+            options.optimize_meshes = true;
+            options.mesh_optimization.weld_epsilon = parse_float(arg, value());
+        } else if (arg == "--quantize") {
+            options.optimize_meshes = true;
+            options.mesh_optimization.quantize_attributes = true;
+        } else if (arg == "--auto-instance") {
+            options.auto_instance = true;
+        } else if (arg == "--flatten-objects") {
+            options.flatten_objects_below = parse_uint(arg, value());
+        } else if (arg == "--transform-table") {
+            options.transform_table = true;
+        } else if (arg == "--mmap-ply") {
+            options.mmap_ply = true;
+        } else if (arg == "--stream-ply") {
+            options.stream_ply = true;
+        } else if (arg == "--split-meshes") {
+            options.stream_ply = true;
+            options.split_meshes_above = parse_uint(arg, value());
+        } else if (arg == "--link-textures") {
+            options.link_textures = true;
+        } else if (arg == "--incremental") {
+            options.incremental = true;
+        } else if (arg == "--profile") {
+            options.profile = true;
+        } else if (arg == "--profile-report") {
+            options.profile_report = value();
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--summary") {
+            batch_summary = value();
+        } else if (arg.starts_with("-")) {
+            luisa::panic("Unknown option '{}'.", arg);
+        } else {
+            inputs.emplace_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        luisa::println("Usage: {} [options] <scene.pbrt>\n"
+                       "       {} --batch [options] <scene.pbrt|directory>...\n"
+                       "Options:\n"
+                       "  -j, --jobs N                 number of worker threads (default: all cores)\n"
+                       "  --mesh-format obj|ply        file format of the exported meshes (default: obj)\n"
+                       "  --scene-format json|compact|cbor|msgpack|ubjson\n"
+                       "                               file format of the scene description (default: json)\n"
+                       "  --compact                    same as --scene-format compact\n"
+                       "  --no-mesh-dedup              export identical meshes separately\n"
+                       "  --no-texture-folding         keep textures computed from constants as they are\n"
+                       "  --no-material-dedup          keep identical surfaces and textures as separate nodes\n"
+                       "  --keep-unreferenced          keep materials, textures and objects nothing renders\n"
+                       "  --optimize-meshes            weld vertices, drop degenerate triangles and sort them\n"
+                       "                               spatially before writing the meshes\n"
+                       "  --weld-epsilon E             weld vertices up to E apart, implies --optimize-meshes\n"
+                       "  --quantize                   round normals and uvs so that nearly equal vertices weld\n"
+                       "                               (still written as float32), implies --optimize-meshes\n"
+                       "  --auto-instance              instance meshes shared by several shapes\n"
+                       "  --flatten-objects N          inline single-use objects with at most N triangles\n"
+                       "  --transform-table            store transforms in one binary table instead of JSON\n"
+                       "  --incremental                skip outputs whose inputs are unchanged since the last run\n"
+                       "  --mmap-ply                   memory-map binary PLY meshes instead of loading them\n"
+                       "  --stream-ply                 export binary PLY meshes in chunks with bounded memory\n"
+                       "  --split-meshes N             split streamed meshes into parts of about N triangles\n"
+                       "  --link-textures              hard-link image files instead of copying them\n"
+                       "  --profile                    print time, bytes written and peak memory per stage\n"
+                       "  --profile-report FILE        write the per-stage profile as JSON to FILE\n"
+                       "  --batch                      convert several scenes concurrently on one thread pool;\n"
+                       "                               directories are searched for .pbrt scene files\n"
+                       "  --summary FILE               write the batch results and timings as JSON to FILE",
+                       argv[0], argv[0]);
+        return EXIT_SUCCESS;
+    }
+    if (!batch) {
+        luisa::expect(inputs.size() == 1u, "Expected a single scene file, use --batch to convert several.");
+        luisa::render::convert(inputs.front().generic_string().c_str(), options);
+        return EXIT_SUCCESS;
+    }
+    auto scene_files = luisa::render::collect_scene_files(inputs);
+    auto summary = luisa::render::convert_batch(scene_files, options);
+    luisa::render::print_batch_summary(summary);
+    if (!batch_summary.empty()) { luisa::render::save_batch_summary(batch_summary, summary); }
+    return summary.failure_count() == 0u ? EXIT_SUCCESS : EXIT_FAILURE;
+}
 
 int main(int argc, char *argv[]) {
-    if (argc == 1) {
-        luisa::println("Usage: {} <scene.pbrt>", argv[0]);
-    } else {
-        luisa::render::convert(argv[1]);
+    try {
+        return run(argc, argv);
+    } catch (const std::exception &e) {
+        luisa::eprintln("{}", e.what());
+        return EXIT_FAILURE;
     }
-    return 0;
 }
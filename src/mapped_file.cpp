@@ -0,0 +1,82 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "mapped_file.h"
+
+namespace luisa {
+
+#ifdef _WIN32
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::filesystem::path &path) noexcept {
+    auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) { return nullptr; }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) { return nullptr; }
+    auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    std::unique_ptr<MappedFile> f{new MappedFile};
+    f->_data = static_cast<const std::byte *>(data);
+    f->_size = static_cast<size_t>(size.QuadPart);
+    f->_mapping = mapping;
+    return f;
+}
+
+MappedFile::~MappedFile() noexcept {
+    UnmapViewOfFile(_data);
+    CloseHandle(_mapping);
+}
+
+#else
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::filesystem::path &path) noexcept {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) { return nullptr; }
+    struct stat s {};
+    if (::fstat(fd, &s) != 0 || s.st_size == 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    auto size = static_cast<size_t>(s.st_size);
+    auto data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);// the mapping keeps the file alive
+    if (data == MAP_FAILED) { return nullptr; }
+    ::madvise(data, size, MADV_SEQUENTIAL);
+    std::unique_ptr<MappedFile> f{new MappedFile};
+    f->_data = static_cast<const std::byte *>(data);
+    f->_size = size;
+    return f;
+}
+
+MappedFile::~MappedFile() noexcept {
+    ::munmap(const_cast<std::byte *>(_data), _size);
+}
+
+#endif
+
+}// namespace luisa
@@ -0,0 +1,39 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <span>
+#include <memory>
+#include <cstddef>
+#include <filesystem>
+
+namespace luisa {
+
+// A read-only memory mapping of a whole file. Pages are backed by the file,
+// so they can be dropped by the OS under memory pressure.
+class MappedFile {
+
+private:
+    const std::byte *_data{nullptr};
+    size_t _size{0u};
+#ifdef _WIN32
+    void *_mapping{nullptr};
+#endif
+
+private:
+    MappedFile() noexcept = default;
+
+public:
+    // returns nullptr if the file cannot be opened or is empty
+    [[nodiscard]] static std::unique_ptr<MappedFile> open(const std::filesystem::path &path) noexcept;
+    ~MappedFile() noexcept;
+    MappedFile(MappedFile &&) noexcept = delete;
+    MappedFile(const MappedFile &) noexcept = delete;
+    MappedFile &operator=(MappedFile &&) noexcept = delete;
+    MappedFile &operator=(const MappedFile &) noexcept = delete;
+    [[nodiscard]] auto bytes() const noexcept { return std::span{_data, _size}; }
+};
+
+}// namespace luisa
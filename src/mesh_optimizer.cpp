@@ -0,0 +1,180 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <bit>
+#include <cmath>
+#include <array>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#include "hash.h"
+#include "logging.h"
+#include "mesh_optimizer.h"
+
+namespace luisa::render {
+
+namespace {
+
+// position, normal and uv of a vertex, zero where absent
+struct Vertex {
+    std::array<float, 3u> p;
+    std::array<float, 3u> n;
+    std::array<float, 2u> uv;
+};
+
+[[nodiscard]] Vertex load_vertex(const MeshView &mesh, uint32_t index, bool quantize) noexcept {
+    Vertex v{};
+    std::memcpy(v.p.data(), mesh.P.at(index), sizeof(v.p));
+    if (mesh.N) { std::memcpy(v.n.data(), mesh.N.at(index), sizeof(v.n)); }
+    if (mesh.uv) { std::memcpy(v.uv.data(), mesh.uv.at(index), sizeof(v.uv)); }
+    if (quantize) {
+        if (auto length = std::sqrt(v.n[0] * v.n[0] + v.n[1] * v.n[1] + v.n[2] * v.n[2]); length > 0.f) {
+            for (auto &x : v.n) { x = std::round(x / length * 32767.f) / 32767.f; }
+        }
+        for (auto &x : v.uv) { x = std::round(x * 65536.f) / 65536.f; }
+    }
+    return v;
+}
+
+// spreads the lower 10 bits of x to every third bit
+[[nodiscard]] constexpr uint32_t spread_bits(uint32_t x) noexcept {
+    x &= 0x3ffu;
+    x = (x | (x << 16u)) & 0x030000ffu;
+    x = (x | (x << 8u)) & 0x0300f00fu;
+    x = (x | (x << 4u)) & 0x030c30c3u;
+    x = (x | (x << 2u)) & 0x09249249u;
+    return x;
+}
+
+}// namespace
+
+MeshBuffers optimize_mesh(const MeshView &mesh, const MeshOptimizeOptions &options) {
+    // weld: vertices are bucketed by grid cell, or by exact position without
+    // a tolerance, and compared against those in the neighbouring buckets
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> remap(mesh.num_vertices);
+    auto eps = options.weld_epsilon;
+    if (eps > 0.f) {
+        auto max_abs = 0.f;
+        for (auto i = 0u; i < mesh.num_vertices; i++) {
+            for (auto x : load_vertex(mesh, i, false).p) {
+                if (std::isfinite(x)) { max_abs = std::max(max_abs, std::abs(x)); }
+            }
+        }
+        eps = std::max(eps, max_abs * 0x1p-40f);
+    }
+    auto cell_of = [eps](const Vertex &v) noexcept {
+        std::array<int64_t, 3u> c{};
+        for (auto i = 0u; i < 3u; i++) {
+            // non-finite positions are never welded, see same(), but still need a cell
+            c[i] = eps > 0.f && std::isfinite(v.p[i]) ?
+                       static_cast<int64_t>(std::floor(v.p[i] / eps)) :
+                       static_cast<int64_t>(std::bit_cast<uint32_t>(v.p[i] + 0.f));// +0 folds -0
+        }
+        return c;
+    };
+    auto cell_hash = [](const std::array<int64_t, 3u> &c) noexcept { return hash64(c.data(), sizeof(c)); };
+    auto same = [eps](const Vertex &a, const Vertex &b) noexcept {
+        for (auto i = 0u; i < 3u; i++) {
+            if (!(std::abs(a.p[i] - b.p[i]) <= eps)) { return false; }
+        }
+        return a.n == b.n && a.uv == b.uv;
+    };
+    // cell hash -> indices of the welded vertices in the cell
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    auto range = eps > 0.f ? 1 : 0;
+    for (auto i = 0u; i < mesh.num_vertices; i++) {
+        auto v = load_vertex(mesh, i, options.quantize_attributes);
+        auto cell = cell_of(v);
+        auto welded = std::numeric_limits<uint32_t>::max();
+        for (auto dx = -range; dx <= range && welded == std::numeric_limits<uint32_t>::max(); dx++) {
+            for (auto dy = -range; dy <= range && welded == std::numeric_limits<uint32_t>::max(); dy++) {
+                for (auto dz = -range; dz <= range && welded == std::numeric_limits<uint32_t>::max(); dz++) {
+                    auto iter = cells.find(cell_hash({cell[0] + dx, cell[1] + dy, cell[2] + dz}));
+                    if (iter == cells.end()) { continue; }
+                    for (auto w : iter->second) {
+                        if (same(vertices[w], v)) {
+                            welded = w;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        if (welded == std::numeric_limits<uint32_t>::max()) {
+            welded = static_cast<uint32_t>(vertices.size());
+            vertices.emplace_back(v);
+            cells[cell_hash(cell)].emplace_back(welded);
+        }
+        remap[i] = welded;
+    }
+    // drop the triangles with repeated vertices or zero area
+    std::vector<std::array<uint32_t, 3u>> triangles;
+    triangles.reserve(mesh.num_triangles);
+    for (auto t = 0u; t < mesh.num_triangles; t++) {
+        int index[3];
+        std::memcpy(index, mesh.indices.at(t), sizeof(index));
+        for (auto i : index) {
+            expect(i >= 0 && static_cast<uint32_t>(i) < mesh.num_vertices, "Invalid mesh vertex index {}.", i);
+        }
+        std::array<uint32_t, 3u> tri{remap[index[0]], remap[index[1]], remap[index[2]]};
+        if (tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0]) { continue; }
+        auto &p0 = vertices[tri[0]].p;
+        auto &p1 = vertices[tri[1]].p;
+        auto &p2 = vertices[tri[2]].p;
+        float e1[3]{p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float e2[3]{p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        float c[3]{e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        if (c[0] == 0.f && c[1] == 0.f && c[2] == 0.f) { continue; }
+        triangles.emplace_back(tri);
+    }
+    // sort the triangles along a Morton curve of their centroids in the mesh bounds
+    std::array<float, 3u> lo{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    std::array<float, 3u> hi{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+    for (auto &&v : vertices) {
+        for (auto i = 0u; i < 3u; i++) {
+            lo[i] = std::min(lo[i], v.p[i]);
+            hi[i] = std::max(hi[i], v.p[i]);
+        }
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> keys(triangles.size());// Morton code, triangle
+    for (auto t = 0u; t < triangles.size(); t++) {
+        auto code = 0u;
+        for (auto i = 0u; i < 3u; i++) {
+            auto centroid = (vertices[triangles[t][0]].p[i] + vertices[triangles[t][1]].p[i] + vertices[triangles[t][2]].p[i]) / 3.f;
+            auto extent = hi[i] - lo[i];
+            auto x = extent > 0.f ? std::clamp((centroid - lo[i]) / extent, 0.f, 1.f) : 0.f;
+            if (std::isnan(x)) { x = 0.f; }// NaN positions, or infinite bounds
+            code |= spread_bits(static_cast<uint32_t>(x * 1023.f)) << i;
+        }
+        keys[t] = {code, t};
+    }
+    std::sort(keys.begin(), keys.end());
+    // renumber the vertices in order of first use, which also drops unused ones
+    MeshBuffers result;
+    std::vector<uint32_t> order(vertices.size(), std::numeric_limits<uint32_t>::max());
+    auto vertex_count = 0u;
+    result.indices.reserve(triangles.size() * 3u);
+    for (auto &&[code, t] : keys) {
+        for (auto v : triangles[t]) {
+            if (order[v] == std::numeric_limits<uint32_t>::max()) { order[v] = vertex_count++; }
+            result.indices.emplace_back(static_cast<int>(order[v]));
+        }
+    }
+    result.P.resize(vertex_count * 3u);
+    if (mesh.N) { result.N.resize(vertex_count * 3u); }
+    if (mesh.uv) { result.uv.resize(vertex_count * 2u); }
+    for (auto v = 0u; v < vertices.size(); v++) {
+        if (auto o = order[v]; o != std::numeric_limits<uint32_t>::max()) {
+            std::copy_n(vertices[v].p.data(), 3u, result.P.data() + o * 3u);
+            if (mesh.N) { std::copy_n(vertices[v].n.data(), 3u, result.N.data() + o * 3u); }
+            if (mesh.uv) { std::copy_n(vertices[v].uv.data(), 2u, result.uv.data() + o * 2u); }
+        }
+    }
+    return result;
+}
+
+}// namespace luisa::render
@@ -0,0 +1,30 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <cstdint>
+
+#include "mesh_view.h"
+
+namespace luisa::render {
+
+struct MeshOptimizeOptions {
+    // vertices whose positions are at most this far apart in every axis, and whose
+    // other attributes are equal, are merged; 0 merges exact duplicates only; raised
+    // to 2^-40 of the largest coordinate, below which the grid cells would overflow
+    float weld_epsilon{0.f};
+    // Normalize normals and round them to 16-bit snorm precision, and round uvs
+    // to 1/65536, so that nearly equal vertices can be welded. Only an aid to
+    // welding: the attributes are still written as float32.
+    bool quantize_attributes{false};
+};
+
+// Welds duplicated vertices with a spatial hash, drops the triangles degenerate
+// after welding, sorts the triangles along a Morton curve of their centroids and
+// renumbers the vertices in order of first use, so that nearby triangles are
+// close in memory. Throws if the mesh has out-of-range indices.
+[[nodiscard]] MeshBuffers optimize_mesh(const MeshView &mesh, const MeshOptimizeOptions &options);
+
+}// namespace luisa::render
@@ -0,0 +1,198 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <cmath>
+#include <array>
+#include <limits>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#include "logging.h"
+#include "ply_mesh.h"
+#include "mesh_splitter.h"
+
+namespace luisa::render {
+
+// records are read in chunks of this many vertices or triangles
+static constexpr auto split_chunk_size = 256u * 1024u;
+
+// spreads the lower 5 bits of x to every third bit
+[[nodiscard]] static constexpr uint32_t spread_grid_bits(uint32_t x) noexcept {
+    x &= 0x1fu;
+    x = (x | (x << 8u)) & 0x100fu;
+    x = (x | (x << 4u)) & 0x10c3u;
+    x = (x | (x << 2u)) & 0x1249u;
+    return x;
+}
+
+// Morton codes of the grid cells of all vertices
+[[nodiscard]] static std::vector<uint16_t> vertex_cells(PlyMeshStream &mesh, const MeshSplitPlan &plan) {
+    constexpr auto resolution = 1u << MeshSplitPlan::grid_bits;
+    std::vector<uint16_t> cells(mesh.num_vertices());
+    for (auto begin = 0u; begin < mesh.num_vertices(); begin += split_chunk_size) {
+        auto count = std::min(split_chunk_size, mesh.num_vertices() - begin);
+        auto chunk = mesh.read_vertices(begin, count);
+        for (auto v = 0u; v < count; v++) {
+            float p[3];
+            std::memcpy(p, chunk.P.at(v), sizeof(p));
+            auto code = 0u;
+            for (auto i = 0u; i < 3u; i++) {
+                auto extent = plan.hi[i] - plan.lo[i];
+                auto x = extent > 0.f ? std::clamp((p[i] - plan.lo[i]) / extent, 0.f, 1.f) : 0.f;
+                if (std::isnan(x)) { x = 0.f; }
+                code |= spread_grid_bits(std::min(static_cast<uint32_t>(x * resolution), resolution - 1u)) << i;
+            }
+            cells[begin + v] = static_cast<uint16_t>(code);
+        }
+    }
+    return cells;
+}
+
+[[nodiscard]] static uint32_t first_vertex(const MeshView &triangles, uint32_t i) noexcept {
+    uint32_t v;
+    std::memcpy(&v, triangles.indices.at(i), sizeof(v));
+    return v;
+}
+
+MeshSplitPlan plan_mesh_split(PlyMeshStream &mesh, uint32_t max_triangles) {
+    expect(max_triangles != 0u, "Invalid mesh part size.");
+    MeshSplitPlan plan;
+    plan.lo.fill(std::numeric_limits<float>::max());
+    plan.hi.fill(std::numeric_limits<float>::lowest());
+    for (auto begin = 0u; begin < mesh.num_vertices(); begin += split_chunk_size) {
+        auto count = std::min(split_chunk_size, mesh.num_vertices() - begin);
+        auto chunk = mesh.read_vertices(begin, count);
+        for (auto v = 0u; v < count; v++) {
+            float p[3];
+            std::memcpy(p, chunk.P.at(v), sizeof(p));
+            for (auto i = 0u; i < 3u; i++) {
+                if (!std::isfinite(p[i])) { continue; }
+                plan.lo[i] = std::min(plan.lo[i], p[i]);
+                plan.hi[i] = std::max(plan.hi[i], p[i]);
+            }
+        }
+    }
+    auto cells = vertex_cells(mesh, plan);
+    std::vector<uint64_t> histogram(MeshSplitPlan::cell_count, 0u);
+    for (auto begin = 0u; begin < mesh.num_triangles(); begin += split_chunk_size) {
+        auto count = std::min(split_chunk_size, mesh.num_triangles() - begin);
+        auto chunk = mesh.read_triangles(begin, count);
+        for (auto t = 0u; t < count; t++) { histogram[cells[first_vertex(chunk, t)]]++; }
+    }
+    // cells are indexed by their Morton codes, so they are visited along the curve
+    plan.cell_parts.resize(MeshSplitPlan::cell_count);
+    auto part_triangles = uint64_t{0u};
+    for (auto cell = 0u; cell < MeshSplitPlan::cell_count; cell++) {
+        if (part_triangles != 0u && part_triangles + histogram[cell] > max_triangles) {
+            plan.part_triangles.emplace_back(part_triangles);
+            plan.part_count++;
+            part_triangles = 0u;
+        }
+        plan.cell_parts[cell] = plan.part_count;
+        part_triangles += histogram[cell];
+    }
+    if (part_triangles != 0u || plan.part_count == 0u) {
+        plan.part_triangles.emplace_back(part_triangles);
+        plan.part_count++;
+    }
+    return plan;
+}
+
+void split_mesh(PlyMeshStream &mesh, const MeshSplitPlan &plan, const std::filesystem::path &temp_file,
+                const std::function<void(uint32_t part, const MeshView &mesh)> &write_part) {
+    using Triangle = std::array<uint32_t, 3u>;
+    // the parts are laid out one after another in the temporary file, in plan order
+    std::vector<uint64_t> part_offsets(plan.part_count + 1u, 0u);
+    for (auto part = 0u; part < plan.part_count; part++) {
+        part_offsets[part + 1u] = part_offsets[part] + plan.part_triangles[part];
+    }
+    expect(part_offsets.back() == mesh.num_triangles(), "Mesh split plan does not match the mesh.");
+    struct TempFile {
+        std::filesystem::path path;
+        std::fstream file;
+        ~TempFile() noexcept {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    } temp{temp_file, std::fstream{temp_file, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary}};
+    expect(temp.file.is_open(), "Failed to create temporary file {}.", temp_file.generic_string());
+    auto write_triangles = [&](uint64_t offset, const std::vector<Triangle> &triangles) {
+        temp.file.seekp(static_cast<std::streamoff>(offset * sizeof(Triangle)));
+        temp.file.write(reinterpret_cast<const char *>(triangles.data()),
+                        static_cast<std::streamsize>(triangles.size() * sizeof(Triangle)));
+        expect(temp.file.good(), "Failed to write temporary file {}.", temp_file.generic_string());
+    };
+    // bucket the triangles by part in a single pass over the face records
+    auto cells = vertex_cells(mesh, plan);
+    {
+        constexpr auto bucket_size = 4096u;
+        std::vector<std::vector<Triangle>> buckets(plan.part_count);
+        auto written = part_offsets;
+        auto flush = [&](uint32_t part) {
+            expect(written[part] + buckets[part].size() <= part_offsets[part + 1u],
+                   "Mesh split plan does not match the mesh.");
+            write_triangles(written[part], buckets[part]);
+            written[part] += buckets[part].size();
+            buckets[part].clear();
+        };
+        for (auto begin = 0u; begin < mesh.num_triangles(); begin += split_chunk_size) {
+            auto count = std::min(split_chunk_size, mesh.num_triangles() - begin);
+            auto chunk = mesh.read_triangles(begin, count);
+            for (auto t = 0u; t < count; t++) {
+                auto part = plan.cell_parts[cells[first_vertex(chunk, t)]];
+                auto &bucket = buckets[part];
+                std::memcpy(bucket.emplace_back().data(), chunk.indices.at(t), sizeof(Triangle));
+                if (bucket.size() == bucket_size) { flush(part); }
+            }
+        }
+        for (auto part = 0u; part < plan.part_count; part++) {
+            if (!buckets[part].empty()) { flush(part); }
+        }
+    }
+    cells = {};
+    std::vector<Triangle> triangles;
+    for (auto part = 0u; part < plan.part_count; part++) {
+        triangles.resize(plan.part_triangles[part]);
+        temp.file.seekg(static_cast<std::streamoff>(part_offsets[part] * sizeof(Triangle)));
+        temp.file.read(reinterpret_cast<char *>(triangles.data()),
+                       static_cast<std::streamsize>(triangles.size() * sizeof(Triangle)));
+        expect(temp.file.good(), "Failed to read temporary file {}.", temp_file.generic_string());
+        MeshBuffers buffers;
+        buffers.indices.reserve(triangles.size() * 3u);
+        // global vertex index -> index in the part
+        std::unordered_map<uint32_t, uint32_t> vertices;
+        for (auto &&triangle : triangles) {
+            for (auto v : triangle) {
+                auto [iter, first] = vertices.try_emplace(v, static_cast<uint32_t>(vertices.size()));
+                buffers.indices.emplace_back(static_cast<int>(iter->second));
+            }
+        }
+        // gather the vertices in runs of nearby records
+        std::vector<std::pair<uint32_t, uint32_t>> order{vertices.cbegin(), vertices.cend()};
+        std::sort(order.begin(), order.end());
+        vertices = {};
+        buffers.P.resize(order.size() * 3u);
+        if (mesh.has_normals()) { buffers.N.resize(order.size() * 3u); }
+        if (mesh.has_uvs()) { buffers.uv.resize(order.size() * 2u); }
+        for (auto run = 0u; run < order.size();) {
+            auto first = order[run].first;
+            auto end = run;
+            while (end < order.size() && order[end].first - first < split_chunk_size) { end++; }
+            auto chunk = mesh.read_vertices(first, order[end - 1u].first - first + 1u);
+            for (auto i = run; i < end; i++) {
+                auto [global, local] = order[i];
+                std::memcpy(buffers.P.data() + local * 3u, chunk.P.at(global - first), sizeof(float) * 3u);
+                if (chunk.N) { std::memcpy(buffers.N.data() + local * 3u, chunk.N.at(global - first), sizeof(float) * 3u); }
+                if (chunk.uv) { std::memcpy(buffers.uv.data() + local * 2u, chunk.uv.at(global - first), sizeof(float) * 2u); }
+            }
+            run = end;
+        }
+        write_part(part, buffers.view());
+    }
+}
+
+}// namespace luisa::render
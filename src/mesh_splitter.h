@@ -0,0 +1,49 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+
+#include "mesh_view.h"
+
+namespace luisa::render {
+
+class PlyMeshStream;
+
+// A spatial partition of a mesh into parts of at most about `max_triangles`
+// triangles. Triangles are binned by the cell of their first vertex in a
+// 32x32x32 grid over the mesh bounds, and consecutive cells along a Morton
+// curve form the parts, so each part is spatially coherent. A single cell
+// with more triangles than the limit becomes a part on its own. Vertices
+// with non-finite coordinates fall into the first cell along that axis.
+struct MeshSplitPlan {
+    static constexpr auto grid_bits = 5u;
+    static constexpr auto cell_count = 1u << (3u * grid_bits);
+    std::array<float, 3u> lo{};
+    std::array<float, 3u> hi{};
+    // Morton code of a cell -> part
+    std::vector<uint32_t> cell_parts;
+    // part -> number of triangles in it
+    std::vector<uint64_t> part_triangles;
+    uint32_t part_count{0u};
+};
+
+// Plans the split with a few passes over the records. Besides the chunk
+// buffers, this needs 2 bytes per vertex.
+[[nodiscard]] MeshSplitPlan plan_mesh_split(PlyMeshStream &mesh, uint32_t max_triangles);
+
+// Gathers the parts of the plan one after another and passes each to `write_part`,
+// with the vertices renumbered in order of first use. The face records are read
+// once and their triangles bucketed by part into `temp_file` (12 bytes per
+// triangle), which is removed afterwards; memory is bounded by the largest part,
+// 2 bytes per vertex and a small buffer per part.
+void split_mesh(PlyMeshStream &mesh, const MeshSplitPlan &plan, const std::filesystem::path &temp_file,
+                const std::function<void(uint32_t part, const MeshView &mesh)> &write_part);
+
+}// namespace luisa::render
@@ -0,0 +1,146 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <vector>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+
+#include <minipbrt.h>
+
+#include "hash.h"
+#include "logging.h"
+#include "mesh_view.h"
+
+namespace luisa::render {
+
+MeshView make_mesh_view(const minipbrt::TriangleMesh *mesh) {
+    expect(mesh->indices, "Mesh indices are null.");
+    expect(mesh->num_indices % 3 == 0, "Invalid number of indices.");
+    auto attribute = [](const void *data, size_t stride) noexcept {
+        return MeshAttribute{static_cast<const std::byte *>(data), stride};
+    };
+    return {.num_vertices = mesh->num_vertices,
+            .num_triangles = mesh->num_indices / 3u,
+            .P = attribute(mesh->P, sizeof(float) * 3u),
+            .N = attribute(mesh->N, sizeof(float) * 3u),
+            .uv = attribute(mesh->uv, sizeof(float) * 2u),
+            .indices = attribute(mesh->indices, sizeof(int) * 3u)};
+}
+
+MeshView MeshBuffers::view() const noexcept {
+    auto attribute = [](const auto &v, size_t stride) noexcept {
+        return v.empty() ? MeshAttribute{} : MeshAttribute{reinterpret_cast<const std::byte *>(v.data()), stride};
+    };
+    return {.num_vertices = static_cast<uint32_t>(P.size() / 3u),
+            .num_triangles = static_cast<uint32_t>(indices.size() / 3u),
+            .P = attribute(P, sizeof(float) * 3u),
+            .N = attribute(N, sizeof(float) * 3u),
+            .uv = attribute(uv, sizeof(float) * 2u),
+            .indices = attribute(indices, sizeof(int) * 3u)};
+}
+
+MeshBuffers copy_mesh(const MeshView &mesh) {
+    auto copy = []<typename T>(const MeshAttribute &a, size_t count, size_t components, std::vector<T> &v) {
+        if (!a) { return; }
+        v.resize(count * components);
+        for (auto i = size_t{0u}; i < count; i++) {
+            std::memcpy(v.data() + i * components, a.at(i), components * sizeof(T));
+        }
+    };
+    MeshBuffers buffers;
+    copy(mesh.P, mesh.num_vertices, 3u, buffers.P);
+    copy(mesh.N, mesh.num_vertices, 3u, buffers.N);
+    copy(mesh.uv, mesh.num_vertices, 2u, buffers.uv);
+    copy(mesh.indices, mesh.num_triangles, 3u, buffers.indices);
+    return buffers;
+}
+
+// Attributes are processed in chunks of a fixed number of elements, gathering
+// strided ones into a staging buffer first, so that the result does not
+// depend on the memory layout.
+static constexpr auto mesh_chunk_size = 64u * 1024u;
+
+[[nodiscard]] static const std::byte *gather_chunk(const MeshAttribute &a, size_t element_size,
+                                                   size_t begin, size_t end,
+                                                   std::vector<std::byte> &staging) noexcept {
+    if (a.stride == element_size) { return a.at(begin); }
+    staging.resize(mesh_chunk_size * element_size);
+    for (auto i = begin; i < end; i++) {
+        std::memcpy(staging.data() + (i - begin) * element_size, a.at(i), element_size);
+    }
+    return staging.data();
+}
+
+uint64_t hash_mesh(const MeshView &mesh) noexcept {
+    uint32_t header[]{mesh.num_vertices, mesh.num_triangles,
+                      static_cast<bool>(mesh.N), static_cast<bool>(mesh.uv)};
+    auto h = hash64(header, sizeof(header));
+    std::vector<std::byte> staging;
+    auto hash_attribute = [&](const MeshAttribute &a, size_t element_size, size_t count) noexcept {
+        if (!a) { return; }
+        for (auto begin = 0u; begin < count; begin += mesh_chunk_size) {
+            auto end = std::min<size_t>(begin + mesh_chunk_size, count);
+            h = hash64(gather_chunk(a, element_size, begin, end, staging), (end - begin) * element_size, h);
+        }
+    };
+    hash_attribute(mesh.P, sizeof(float) * 3u, mesh.num_vertices);
+    hash_attribute(mesh.N, sizeof(float) * 3u, mesh.num_vertices);
+    hash_attribute(mesh.uv, sizeof(float) * 2u, mesh.num_vertices);
+    hash_attribute(mesh.indices, sizeof(int) * 3u, mesh.num_triangles);
+    return h;
+}
+
+bool mesh_equal(const MeshView &a, const MeshView &b) noexcept {
+    if (a.num_vertices != b.num_vertices ||
+        a.num_triangles != b.num_triangles ||
+        static_cast<bool>(a.N) != static_cast<bool>(b.N) ||
+        static_cast<bool>(a.uv) != static_cast<bool>(b.uv)) {
+        return false;
+    }
+    std::vector<std::byte> staging_a;
+    std::vector<std::byte> staging_b;
+    auto equal_attribute = [&](const MeshAttribute &x, const MeshAttribute &y,
+                               size_t element_size, size_t count) noexcept {
+        if (!x || (x.data == y.data && x.stride == y.stride)) { return true; }
+        for (auto begin = 0u; begin < count; begin += mesh_chunk_size) {
+            auto end = std::min<size_t>(begin + mesh_chunk_size, count);
+            if (std::memcmp(gather_chunk(x, element_size, begin, end, staging_a),
+                            gather_chunk(y, element_size, begin, end, staging_b),
+                            (end - begin) * element_size) != 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+    return equal_attribute(a.P, b.P, sizeof(float) * 3u, a.num_vertices) &&
+           equal_attribute(a.N, b.N, sizeof(float) * 3u, a.num_vertices) &&
+           equal_attribute(a.uv, b.uv, sizeof(float) * 2u, a.num_vertices) &&
+           equal_attribute(a.indices, b.indices, sizeof(int) * 3u, a.num_triangles);
+}
+
+std::vector<uint32_t> find_identical_meshes(const std::vector<uint64_t> &hashes,
+                                            const std::function<bool(uint32_t)> &included,
+                                            const std::function<bool(uint32_t, uint32_t)> &equal) {
+    std::vector<uint32_t> identical(hashes.size());
+    std::iota(identical.begin(), identical.end(), 0u);
+    // hash -> indices of the distinct meshes seen so far
+    std::unordered_map<uint64_t, std::vector<uint32_t>> groups;
+    for (auto i = 0u; i < hashes.size(); i++) {
+        if (!included(i)) { continue; }
+        auto &candidates = groups[hashes[i]];
+        if (auto iter = std::find_if(candidates.cbegin(), candidates.cend(), [&](auto c) {
+                return equal(i, c);
+            });
+            iter != candidates.cend()) {
+            identical[i] = *iter;
+        } else {
+            candidates.emplace_back(i);
+        }
+    }
+    return identical;
+}
+
+}// namespace luisa::render
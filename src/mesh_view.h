@@ -0,0 +1,62 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <functional>
+
+namespace minipbrt {
+struct TriangleMesh;
+}// namespace minipbrt
+
+namespace luisa::render {
+
+// A strided array of fixed-size elements in memory.
+struct MeshAttribute {
+    const std::byte *data{nullptr};
+    size_t stride{0u};
+    [[nodiscard]] explicit operator bool() const noexcept { return data != nullptr; }
+    [[nodiscard]] auto at(size_t i) const noexcept { return data + i * stride; }
+};
+
+// A read-only view of a triangle mesh. The attributes may live in separate
+// arrays, as in minipbrt::TriangleMesh, or be interleaved, as in a binary
+// PLY file mapped into memory.
+struct MeshView {
+    uint32_t num_vertices{0u};
+    uint32_t num_triangles{0u};
+    MeshAttribute P;      // float3
+    MeshAttribute N;      // float3, optional
+    MeshAttribute uv;     // float2, optional
+    MeshAttribute indices;// int3 per triangle
+};
+
+// A triangle mesh owning tightly packed attribute arrays; N and uv may be empty.
+struct MeshBuffers {
+    std::vector<float> P;
+    std::vector<float> N;
+    std::vector<float> uv;
+    std::vector<int> indices;
+    [[nodiscard]] MeshView view() const noexcept;
+};
+
+[[nodiscard]] MeshView make_mesh_view(const minipbrt::TriangleMesh *mesh);
+// copies the attributes into tightly packed arrays
+[[nodiscard]] MeshBuffers copy_mesh(const MeshView &mesh);
+
+// hash and comparison of the mesh content, independent of the memory layout
+[[nodiscard]] uint64_t hash_mesh(const MeshView &mesh) noexcept;
+[[nodiscard]] bool mesh_equal(const MeshView &a, const MeshView &b) noexcept;
+
+// Returns, for each mesh i, the index of the first mesh identical to it, or i
+// itself. Only the meshes for which included(i) holds take part; equal(i, j)
+// is called for meshes of the same hash only, and decides on hash collisions.
+[[nodiscard]] std::vector<uint32_t> find_identical_meshes(const std::vector<uint64_t> &hashes,
+                                                          const std::function<bool(uint32_t)> &included,
+                                                          const std::function<bool(uint32_t, uint32_t)> &equal);
+
+}// namespace luisa::render
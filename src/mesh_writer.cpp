@@ -0,0 +1,308 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <bit>
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <type_traits>
+
+#include "logging.h"
+#include "async_file_writer.h"
+#include "ply_mesh.h"
+#include "mesh_writer.h"
+
+namespace luisa::render {
+
+std::string_view mesh_format_extension(MeshFormat format) noexcept {
+    switch (format) {
+        case MeshFormat::OBJ: return "obj";
+        case MeshFormat::PLY: return "ply";
+    }
+    panic("Invalid mesh format.");
+}
+
+namespace {
+
+// Formats OBJ records straight into a large buffer that is handed to the I/O
+// threads when full, so no temporary string is created per line and the
+// formatting of the next chunk overlaps with writing the previous one.
+class WavefrontObjWriter {
+
+public:
+    static constexpr auto buffer_size = 4u * 1024u * 1024u;
+    // the longest record is a face with 9 indices, well below this
+    static constexpr auto max_record_size = 256u;
+
+private:
+    AsyncFileWriter _file;
+    AsyncFileWriter::Buffer _buffer;
+    size_t _size{0u};
+
+public:
+    explicit WavefrontObjWriter(const std::filesystem::path &file_name)
+        : _file{file_name} {
+        expect(_file.is_open(), "Failed to open mesh file {}.", file_name.generic_string());
+        _buffer.resize(buffer_size);
+    }
+    WavefrontObjWriter(WavefrontObjWriter &&) noexcept = delete;
+    WavefrontObjWriter(const WavefrontObjWriter &) noexcept = delete;
+    void flush() {
+        _buffer.resize(_size);
+        _buffer = _file.submit(std::move(_buffer));
+        _buffer.resize(buffer_size);
+        _size = 0u;
+    }
+    // must be called before each record to guarantee enough space in the buffer
+    void begin_record() {
+        if (_size + max_record_size > buffer_size) { flush(); }
+    }
+    void put(char c) noexcept { _buffer[_size++] = c; }
+    void put(std::string_view s) noexcept {
+        std::memcpy(_buffer.data() + _size, s.data(), s.size());
+        _size += s.size();
+    }
+    template<typename T>
+        requires std::is_arithmetic_v<T>
+    void put(T x) noexcept {
+        auto p = _buffer.data() + _size;
+        auto [end, ec] = std::to_chars(p, p + max_record_size, x);
+        _size += end - p;
+    }
+    // flushes and waits for the writes, returns whether all succeeded
+    [[nodiscard]] bool close() {
+        flush();
+        return _file.close();
+    }
+};
+
+template<size_t dim>
+void write_obj_vertex_records(WavefrontObjWriter &w, std::string_view prefix,
+                              const MeshAttribute &a, uint32_t n) {
+    for (auto v = 0u; v < n; v++) {
+        float x[dim];
+        std::memcpy(x, a.at(v), sizeof(x));
+        w.begin_record();
+        w.put(prefix);
+        for (auto i = 0u; i < dim; i++) {
+            w.put(' ');
+            w.put(x[i]);
+        }
+        w.put('\n');
+    }
+}
+
+// face layouts: "f v", "f v/vt", "f v//vn" or "f v/vt/vn", resolved at compile time
+template<bool has_normal, bool has_uv>
+void write_obj_face_records(WavefrontObjWriter &w, const MeshAttribute &indices, uint32_t n) {
+    for (auto i = 0u; i < n; i++) {
+        int triangle[3];
+        std::memcpy(triangle, indices.at(i), sizeof(triangle));
+        w.begin_record();
+        w.put('f');
+        for (auto k = 0u; k < 3u; k++) {
+            auto index = triangle[k] + 1;
+            w.put(' ');
+            w.put(index);
+            if constexpr (has_uv) {
+                w.put('/');
+                w.put(index);
+            } else if constexpr (has_normal) {
+                w.put('/');
+            }
+            if constexpr (has_normal) {
+                w.put('/');
+                w.put(index);
+            }
+        }
+        w.put('\n');
+    }
+}
+
+}// namespace
+
+void dump_mesh_to_wavefront_obj(
+    const std::filesystem::path &file_name,
+    const MeshView &mesh) {
+    WavefrontObjWriter w{file_name};
+    w.put("# Converted from PLY mesh\n");
+    write_obj_vertex_records<3u>(w, "v", mesh.P, mesh.num_vertices);
+    if (mesh.N) { write_obj_vertex_records<3u>(w, "vn", mesh.N, mesh.num_vertices); }
+    if (mesh.uv) { write_obj_vertex_records<2u>(w, "vt", mesh.uv, mesh.num_vertices); }
+    if (mesh.N) {
+        if (mesh.uv) {
+            write_obj_face_records<true, true>(w, mesh.indices, mesh.num_triangles);
+        } else {
+            write_obj_face_records<true, false>(w, mesh.indices, mesh.num_triangles);
+        }
+    } else {
+        if (mesh.uv) {
+            write_obj_face_records<false, true>(w, mesh.indices, mesh.num_triangles);
+        } else {
+            write_obj_face_records<false, false>(w, mesh.indices, mesh.num_triangles);
+        }
+    }
+    expect(w.close(), "Failed to write mesh file {}.", file_name.generic_string());
+}
+
+// the header of a binary PLY mesh in native byte order
+[[nodiscard]] static std::string binary_ply_header(uint32_t num_vertices, bool has_normal, bool has_uv,
+                                                   uint32_t num_triangles) noexcept {
+    auto header = luisa::format("ply\n"
+                                "format {} 1.0\n"
+                                "comment Converted by pbrt2luisa\n"
+                                "element vertex {}\n"
+                                "property float x\n"
+                                "property float y\n"
+                                "property float z\n",
+                                std::endian::native == std::endian::little ?
+                                    "binary_little_endian" :
+                                    "binary_big_endian",
+                                num_vertices);
+    if (has_normal) {
+        header.append("property float nx\n"
+                      "property float ny\n"
+                      "property float nz\n");
+    }
+    if (has_uv) {
+        header.append("property float u\n"
+                      "property float v\n");
+    }
+    header.append(luisa::format("element face {}\n"
+                                "property list uchar int vertex_indices\n"
+                                "end_header\n",
+                                num_triangles));
+    return header;
+}
+
+// vertices: PLY interleaves the attributes, so they go through a staging
+// buffer unless there are only tightly packed positions, which are written in bulk
+static void write_binary_ply_vertices(AsyncFileWriter &f, const MeshView &mesh) {
+    constexpr auto chunk_size = 64u * 1024u;
+    constexpr auto float3_size = 3u * sizeof(float);
+    constexpr auto float2_size = 2u * sizeof(float);
+    if (!mesh.N && !mesh.uv && mesh.P.stride == float3_size) {
+        f.write(mesh.P.data, mesh.num_vertices * float3_size);
+    } else {
+        auto stride = float3_size + (mesh.N ? float3_size : 0u) + (mesh.uv ? float2_size : 0u);
+        AsyncFileWriter::Buffer staging;
+        for (auto begin = 0u; begin < mesh.num_vertices; begin += chunk_size) {
+            auto end = std::min(begin + chunk_size, mesh.num_vertices);
+            staging.resize(chunk_size * stride);
+            auto out = reinterpret_cast<std::byte *>(staging.data());
+            for (auto v = begin; v < end; v++) {
+                out = std::copy_n(mesh.P.at(v), float3_size, out);
+                if (mesh.N) { out = std::copy_n(mesh.N.at(v), float3_size, out); }
+                if (mesh.uv) { out = std::copy_n(mesh.uv.at(v), float2_size, out); }
+            }
+            staging.resize((end - begin) * stride);
+            staging = f.submit(std::move(staging));
+        }
+    }
+}
+
+// faces: each is a one-byte count followed by three 32-bit indices
+static void write_binary_ply_faces(AsyncFileWriter &f, const MeshView &mesh) {
+    constexpr auto chunk_size = 64u * 1024u;
+    constexpr auto face_size = 1u + 3u * sizeof(int);
+    AsyncFileWriter::Buffer staging;
+    for (auto begin = 0u; begin < mesh.num_triangles; begin += chunk_size) {
+        auto end = std::min(begin + chunk_size, mesh.num_triangles);
+        staging.resize((end - begin) * face_size);
+        auto out = staging.data();
+        for (auto i = begin; i < end; i++) {
+            *out = 3;
+            std::memcpy(out + 1, mesh.indices.at(i), 3u * sizeof(int));
+            out += face_size;
+        }
+        staging = f.submit(std::move(staging));
+    }
+}
+
+void dump_mesh_to_binary_ply(
+    const std::filesystem::path &file_name,
+    const MeshView &mesh) {
+    AsyncFileWriter f{file_name};
+    expect(f.is_open(), "Failed to open mesh file {}.", file_name.generic_string());
+    auto header = binary_ply_header(mesh.num_vertices, static_cast<bool>(mesh.N),
+                                    static_cast<bool>(mesh.uv), mesh.num_triangles);
+    f.write(header.data(), header.size());
+    write_binary_ply_vertices(f, mesh);
+    write_binary_ply_faces(f, mesh);
+    expect(f.close(), "Failed to write mesh file {}.", file_name.generic_string());
+}
+
+void dump_mesh(const std::filesystem::path &file_name,
+               const MeshView &mesh,
+               MeshFormat format) {
+    switch (format) {
+        case MeshFormat::OBJ: dump_mesh_to_wavefront_obj(file_name, mesh); break;
+        case MeshFormat::PLY: dump_mesh_to_binary_ply(file_name, mesh); break;
+    }
+}
+
+// the records are read in chunks of this many vertices or triangles
+static constexpr auto mesh_stream_chunk_size = 256u * 1024u;
+
+void dump_mesh_stream_to_wavefront_obj(const std::filesystem::path &file_name, PlyMeshStream &mesh) {
+    WavefrontObjWriter w{file_name};
+    w.put("# Converted from PLY mesh\n");
+    // OBJ lists each attribute separately, so the vertices are read once per attribute
+    auto write_attribute = [&](std::string_view prefix, auto dim, MeshAttribute MeshView::*attribute) {
+        for (auto begin = 0u; begin < mesh.num_vertices(); begin += mesh_stream_chunk_size) {
+            auto count = std::min(mesh_stream_chunk_size, mesh.num_vertices() - begin);
+            write_obj_vertex_records<decltype(dim)::value>(w, prefix, mesh.read_vertices(begin, count).*attribute, count);
+        }
+    };
+    write_attribute("v", std::integral_constant<size_t, 3u>{}, &MeshView::P);
+    if (mesh.has_normals()) { write_attribute("vn", std::integral_constant<size_t, 3u>{}, &MeshView::N); }
+    if (mesh.has_uvs()) { write_attribute("vt", std::integral_constant<size_t, 2u>{}, &MeshView::uv); }
+    for (auto begin = 0u; begin < mesh.num_triangles(); begin += mesh_stream_chunk_size) {
+        auto count = std::min(mesh_stream_chunk_size, mesh.num_triangles() - begin);
+        auto indices = mesh.read_triangles(begin, count).indices;
+        if (mesh.has_normals()) {
+            if (mesh.has_uvs()) {
+                write_obj_face_records<true, true>(w, indices, count);
+            } else {
+                write_obj_face_records<true, false>(w, indices, count);
+            }
+        } else {
+            if (mesh.has_uvs()) {
+                write_obj_face_records<false, true>(w, indices, count);
+            } else {
+                write_obj_face_records<false, false>(w, indices, count);
+            }
+        }
+    }
+    expect(w.close(), "Failed to write mesh file {}.", file_name.generic_string());
+}
+
+void dump_mesh_stream_to_binary_ply(const std::filesystem::path &file_name, PlyMeshStream &mesh) {
+    AsyncFileWriter f{file_name};
+    expect(f.is_open(), "Failed to open mesh file {}.", file_name.generic_string());
+    auto header = binary_ply_header(mesh.num_vertices(), mesh.has_normals(), mesh.has_uvs(), mesh.num_triangles());
+    f.write(header.data(), header.size());
+    for (auto begin = 0u; begin < mesh.num_vertices(); begin += mesh_stream_chunk_size) {
+        auto count = std::min(mesh_stream_chunk_size, mesh.num_vertices() - begin);
+        write_binary_ply_vertices(f, mesh.read_vertices(begin, count));
+    }
+    for (auto begin = 0u; begin < mesh.num_triangles(); begin += mesh_stream_chunk_size) {
+        auto count = std::min(mesh_stream_chunk_size, mesh.num_triangles() - begin);
+        write_binary_ply_faces(f, mesh.read_triangles(begin, count));
+    }
+    expect(f.close(), "Failed to write mesh file {}.", file_name.generic_string());
+}
+
+void dump_mesh_stream(const std::filesystem::path &file_name,
+                      PlyMeshStream &mesh,
+                      MeshFormat format) {
+    switch (format) {
+        case MeshFormat::OBJ: dump_mesh_stream_to_wavefront_obj(file_name, mesh); break;
+        case MeshFormat::PLY: dump_mesh_stream_to_binary_ply(file_name, mesh); break;
+    }
+}
+
+}// namespace luisa::render
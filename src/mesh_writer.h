@@ -0,0 +1,45 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <filesystem>
+
+#include "mesh_view.h"
+
+namespace luisa::render {
+
+class PlyMeshStream;
+
+enum struct MeshFormat : uint8_t {
+    OBJ,// Wavefront OBJ, text
+    PLY,// binary PLY in native byte order
+};
+
+[[nodiscard]] std::string_view mesh_format_extension(MeshFormat format) noexcept;
+
+void dump_mesh_to_wavefront_obj(const std::filesystem::path &file_name,
+                                const MeshView &mesh);
+
+void dump_mesh_to_binary_ply(const std::filesystem::path &file_name,
+                             const MeshView &mesh);
+
+void dump_mesh(const std::filesystem::path &file_name,
+               const MeshView &mesh,
+               MeshFormat format);
+
+// Same as above for meshes read in chunks, with memory bounded by the chunk size.
+void dump_mesh_stream_to_wavefront_obj(const std::filesystem::path &file_name,
+                                       PlyMeshStream &mesh);
+
+void dump_mesh_stream_to_binary_ply(const std::filesystem::path &file_name,
+                                    PlyMeshStream &mesh);
+
+void dump_mesh_stream(const std::filesystem::path &file_name,
+                      PlyMeshStream &mesh,
+                      MeshFormat format);
+
+}// namespace luisa::render
@@ -0,0 +1,278 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <bit>
+#include <limits>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <optional>
+#include <string_view>
+
+#include "hash.h"
+#include "logging.h"
+#include "ply_mesh.h"
+
+namespace luisa::render {
+
+namespace {
+
+struct PlyProperty {
+    std::string_view name;
+    size_t size{0u};// of the value, or of the list count
+    size_t item_size{0u};
+    bool is_float{false};
+    bool is_list{false};
+};
+
+struct PlyElement {
+    std::string_view name;
+    size_t count{0u};
+    std::vector<PlyProperty> properties;
+};
+
+[[nodiscard]] size_t ply_type_size(std::string_view type) noexcept {
+    if (type == "char" || type == "uchar" || type == "int8" || type == "uint8") { return 1u; }
+    if (type == "short" || type == "ushort" || type == "int16" || type == "uint16") { return 2u; }
+    if (type == "int" || type == "uint" || type == "int32" || type == "uint32" ||
+        type == "float" || type == "float32") { return 4u; }
+    if (type == "double" || type == "float64") { return 8u; }
+    return 0u;
+}
+
+[[nodiscard]] std::vector<std::string_view> split(std::string_view line) noexcept {
+    std::vector<std::string_view> tokens;
+    while (!line.empty()) {
+        auto begin = line.find_first_not_of(" \t");
+        if (begin == std::string_view::npos) { break; }
+        line.remove_prefix(begin);
+        auto end = std::min(line.find_first_of(" \t"), line.size());
+        tokens.emplace_back(line.substr(0u, end));
+        line.remove_prefix(end);
+    }
+    return tokens;
+}
+
+// parses the header, returns the elements and the offset of the payload
+[[nodiscard]] std::optional<std::pair<std::vector<PlyElement>, size_t>>
+parse_binary_ply_header(std::string_view text) noexcept {
+    constexpr auto native_format = std::endian::native == std::endian::little ?
+                                       "binary_little_endian" :
+                                       "binary_big_endian";
+    std::vector<PlyElement> elements;
+    auto offset = 0u;
+    auto native = false;
+    for (auto line_index = 0u;; line_index++) {
+        auto eol = text.find('\n', offset);
+        if (eol == std::string_view::npos) { return std::nullopt; }
+        auto line = text.substr(offset, eol - offset);
+        offset = eol + 1u;
+        if (line.ends_with('\r')) { line.remove_suffix(1u); }
+        auto tokens = split(line);
+        if (line_index == 0u) {
+            if (tokens.size() != 1u || tokens[0] != "ply") { return std::nullopt; }
+            continue;
+        }
+        if (tokens.empty() || tokens[0] == "comment" || tokens[0] == "obj_info") { continue; }
+        if (tokens[0] == "end_header") { break; }
+        if (tokens[0] == "format") {
+            native = tokens.size() == 3u && tokens[1] == native_format;
+        } else if (tokens[0] == "element") {
+            if (tokens.size() != 3u) { return std::nullopt; }
+            auto &e = elements.emplace_back();
+            e.name = tokens[1];
+            auto [p, ec] = std::from_chars(tokens[2].data(), tokens[2].data() + tokens[2].size(), e.count);
+            if (ec != std::errc{}) { return std::nullopt; }
+        } else if (tokens[0] == "property") {
+            if (elements.empty()) { return std::nullopt; }
+            auto &p = elements.back().properties.emplace_back();
+            if (tokens.size() == 3u) {
+                p.name = tokens[2];
+                p.size = ply_type_size(tokens[1]);
+                p.is_float = tokens[1] == "float" || tokens[1] == "float32";
+            } else if (tokens.size() == 5u && tokens[1] == "list") {
+                p.name = tokens[4];
+                p.size = ply_type_size(tokens[2]);
+                p.item_size = ply_type_size(tokens[3]);
+                p.is_list = true;
+                if (p.item_size == 0u) { return std::nullopt; }
+            } else {
+                return std::nullopt;
+            }
+            if (p.size == 0u) { return std::nullopt; }
+        } else {
+            return std::nullopt;
+        }
+    }
+    if (!native) { return std::nullopt; }
+    return std::make_pair(std::move(elements), offset);
+}
+
+// parses the header at the start of `text` and checks that the layout is supported
+[[nodiscard]] std::optional<PlyMeshLayout> parse_ply_mesh_layout(std::string_view text) noexcept {
+    auto header = parse_binary_ply_header(text);
+    if (!header) { return std::nullopt; }
+    auto &&[elements, payload_offset] = *header;
+    if (elements.size() < 2u || elements[0].name != "vertex" || elements[1].name != "face") { return std::nullopt; }
+    auto &vertex = elements[0];
+    auto &face = elements[1];
+    if (vertex.count > std::numeric_limits<uint32_t>::max() ||
+        face.count > std::numeric_limits<uint32_t>::max()) { return std::nullopt; }
+    // vertex layout: all properties must have a fixed size
+    auto vertex_stride = 0u;
+    auto find_float = [&](std::string_view name) noexcept -> std::optional<size_t> {
+        auto offset = 0u;
+        for (auto &&p : vertex.properties) {
+            if (p.name == name) {
+                if (!p.is_float) { return std::nullopt; }
+                return offset;
+            }
+            offset += p.size;
+        }
+        return std::nullopt;
+    };
+    for (auto &&p : vertex.properties) {
+        if (p.is_list) { return std::nullopt; }
+        vertex_stride += p.size;
+    }
+    // a group of float properties must be consecutive to be viewed in place
+    auto find_vector = [&](std::initializer_list<std::string_view> names) noexcept -> std::optional<size_t> {
+        auto first = find_float(*names.begin());
+        if (!first) { return std::nullopt; }
+        auto expected = *first;
+        for (auto name : names) {
+            if (auto o = find_float(name); !o || *o != expected) { return std::nullopt; }
+            expected += sizeof(float);
+        }
+        return first;
+    };
+    auto position = find_vector({"x", "y", "z"});
+    if (!position) { return std::nullopt; }
+    auto normal = find_vector({"nx", "ny", "nz"});
+    auto uv = find_vector({"u", "v"});
+    if (!uv) { uv = find_vector({"s", "t"}); }
+    if (!uv) { uv = find_vector({"texture_u", "texture_v"}); }
+    if (!uv) { uv = find_vector({"texture_s", "texture_t"}); }
+    // face layout: a single list of 32-bit indices with a one-byte count
+    if (face.properties.size() != 1u) { return std::nullopt; }
+    if (auto &&p = face.properties.front();
+        !p.is_list || p.size != 1u || p.item_size != sizeof(int) ||
+        (p.name != "vertex_indices" && p.name != "vertex_index")) {
+        return std::nullopt;
+    }
+    return PlyMeshLayout{.num_vertices = static_cast<uint32_t>(vertex.count),
+                         .num_triangles = static_cast<uint32_t>(face.count),
+                         .vertex_offset = payload_offset,
+                         .vertex_stride = vertex_stride,
+                         .face_offset = payload_offset + vertex.count * vertex_stride,
+                         .position = *position,
+                         .normal = normal,
+                         .uv = uv};
+}
+
+// every face must be an in-range triangle
+[[nodiscard]] bool valid_ply_faces(const std::byte *faces, uint32_t count, uint32_t num_vertices) noexcept {
+    for (auto i = 0u; i < count; i++) {
+        auto record = faces + i * PlyMeshLayout::face_stride;
+        uint32_t indices[3];
+        std::memcpy(indices, record + 1u, sizeof(indices));
+        if (static_cast<uint8_t>(record[0]) != 3u ||
+            indices[0] >= num_vertices ||
+            indices[1] >= num_vertices ||
+            indices[2] >= num_vertices) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}// namespace
+
+std::unique_ptr<MappedPlyMesh> map_binary_ply_mesh(const std::filesystem::path &path) noexcept {
+    auto file = MappedFile::open(path);
+    if (file == nullptr) { return nullptr; }
+    auto bytes = file->bytes();
+    auto layout = parse_ply_mesh_layout({reinterpret_cast<const char *>(bytes.data()), bytes.size()});
+    if (!layout || layout->file_size() > bytes.size()) { return nullptr; }
+    auto faces = bytes.data() + layout->face_offset;
+    if (!valid_ply_faces(faces, layout->num_triangles, layout->num_vertices)) { return nullptr; }
+    auto view = layout->view(bytes.data() + layout->vertex_offset, layout->num_vertices,
+                             faces, layout->num_triangles);
+    return std::make_unique<MappedPlyMesh>(std::move(file), view);
+}
+
+MeshView PlyMeshLayout::view(const std::byte *vertices, uint32_t vertex_count,
+                             const std::byte *faces, uint32_t triangle_count) const noexcept {
+    auto vertex_attribute = [&](std::optional<size_t> offset) noexcept {
+        if (!offset || vertices == nullptr) { return MeshAttribute{}; }
+        return MeshAttribute{vertices + *offset, vertex_stride};
+    };
+    return {.num_vertices = vertex_count,
+            .num_triangles = triangle_count,
+            .P = vertex_attribute(position),
+            .N = vertex_attribute(normal),
+            .uv = vertex_attribute(uv),
+            .indices = faces == nullptr ? MeshAttribute{} : MeshAttribute{faces + 1u, face_stride}};
+}
+
+PlyMeshStream::PlyMeshStream(std::ifstream file, std::filesystem::path path, const PlyMeshLayout &layout) noexcept
+    : _file{std::move(file)}, _path{std::move(path)}, _layout{layout} {}
+
+std::unique_ptr<PlyMeshStream> PlyMeshStream::open(const std::filesystem::path &path) noexcept {
+    std::ifstream file{path, std::ios::binary};
+    if (!file.is_open()) { return nullptr; }
+    // the header is read in growing pieces until it is complete
+    std::string header;
+    for (auto size = 4096u; size <= 1024u * 1024u; size *= 4u) {
+        header.resize(size);
+        file.clear();
+        file.seekg(0);
+        file.read(header.data(), static_cast<std::streamsize>(size));
+        header.resize(static_cast<size_t>(file.gcount()));
+        if (header.find("end_header") != std::string::npos || header.size() < size) { break; }
+    }
+    auto layout = parse_ply_mesh_layout(header);
+    std::error_code error;
+    if (!layout || layout->file_size() > std::filesystem::file_size(path, error) || error) { return nullptr; }
+    file.clear();
+    return std::unique_ptr<PlyMeshStream>{
+        new PlyMeshStream{std::move(file), path, *layout}};
+}
+
+void PlyMeshStream::_read(size_t offset, size_t size, std::vector<std::byte> &buffer) {
+    buffer.resize(size);
+    _file.seekg(static_cast<std::streamoff>(offset));
+    _file.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(size));
+    expect(_file.good(), "Failed to read PLY mesh file {}.", _path.generic_string());
+}
+
+MeshView PlyMeshStream::read_vertices(uint32_t first, uint32_t count) {
+    expect(first <= _layout.num_vertices && count <= _layout.num_vertices - first, "Invalid PLY vertex range.");
+    _read(_layout.vertex_offset + first * _layout.vertex_stride, count * _layout.vertex_stride, _vertices);
+    return _layout.view(_vertices.data(), count, nullptr, 0u);
+}
+
+MeshView PlyMeshStream::read_triangles(uint32_t first, uint32_t count) {
+    expect(first <= _layout.num_triangles && count <= _layout.num_triangles - first, "Invalid PLY face range.");
+    _read(_layout.face_offset + first * PlyMeshLayout::face_stride, count * PlyMeshLayout::face_stride, _faces);
+    expect(valid_ply_faces(_faces.data(), count, _layout.num_vertices),
+           "Invalid face in PLY mesh file {}.", _path.generic_string());
+    return _layout.view(nullptr, 0u, _faces.data(), count);
+}
+
+uint64_t PlyMeshStream::hash() {
+    std::vector<std::byte> buffer;
+    auto h = hash64(_path.generic_string());
+    constexpr auto chunk_size = 4u * 1024u * 1024u;
+    for (auto offset = size_t{0u}; offset < _layout.file_size(); offset += chunk_size) {
+        auto size = std::min<size_t>(chunk_size, _layout.file_size() - offset);
+        _read(offset, size, buffer);
+        h = hash64(buffer.data(), size, h);
+    }
+    return h;
+}
+
+}// namespace luisa::render
@@ -0,0 +1,83 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <filesystem>
+
+#include "mapped_file.h"
+#include "mesh_view.h"
+
+namespace luisa::render {
+
+// A binary PLY triangle mesh mapped into memory. The view points directly
+// into the vertex and face records of the mapping.
+struct MappedPlyMesh {
+    std::unique_ptr<MappedFile> file;
+    MeshView view;
+};
+
+// Returns nullptr unless the file is a binary PLY in native byte order with a
+// "vertex" element of fixed-size properties, with float x/y/z and optional
+// float normals and uvs, followed by a "face" element made only of triangles
+// stored as "list uchar int vertex_indices".
+[[nodiscard]] std::unique_ptr<MappedPlyMesh> map_binary_ply_mesh(const std::filesystem::path &path) noexcept;
+
+// Record layout of a binary PLY triangle mesh: a "vertex" element of fixed-size
+// properties followed by a "face" element of triangles with 32-bit indices.
+struct PlyMeshLayout {
+    static constexpr auto face_stride = 1u + 3u * sizeof(int);
+    uint32_t num_vertices{0u};
+    uint32_t num_triangles{0u};
+    size_t vertex_offset{0u};
+    size_t vertex_stride{0u};
+    size_t face_offset{0u};
+    // offsets of the attributes in the vertex records
+    size_t position{0u};
+    std::optional<size_t> normal;
+    std::optional<size_t> uv;
+    [[nodiscard]] auto file_size() const noexcept { return face_offset + num_triangles * face_stride; }
+    // a view of consecutive vertex and face records; either may be null
+    [[nodiscard]] MeshView view(const std::byte *vertices, uint32_t vertex_count,
+                                const std::byte *faces, uint32_t triangle_count) const noexcept;
+};
+
+// A binary PLY triangle mesh of the layout accepted by map_binary_ply_mesh(),
+// read in chunks of records, so that meshes too large to be loaded or mapped
+// at once are converted with bounded memory.
+class PlyMeshStream {
+
+private:
+    std::ifstream _file;
+    std::filesystem::path _path;
+    PlyMeshLayout _layout;
+    std::vector<std::byte> _vertices;
+    std::vector<std::byte> _faces;
+
+private:
+    PlyMeshStream(std::ifstream file, std::filesystem::path path, const PlyMeshLayout &layout) noexcept;
+    void _read(size_t offset, size_t size, std::vector<std::byte> &buffer);
+
+public:
+    // returns nullptr if the file cannot be opened or its layout is not supported
+    [[nodiscard]] static std::unique_ptr<PlyMeshStream> open(const std::filesystem::path &path) noexcept;
+    [[nodiscard]] auto num_vertices() const noexcept { return _layout.num_vertices; }
+    [[nodiscard]] auto num_triangles() const noexcept { return _layout.num_triangles; }
+    [[nodiscard]] auto has_normals() const noexcept { return _layout.normal.has_value(); }
+    [[nodiscard]] auto has_uvs() const noexcept { return _layout.uv.has_value(); }
+    // Read a range of vertex or face records. The returned view holds only the
+    // records read and stays valid until the next read of the same kind.
+    // Throw on read errors and on faces that are not in-range triangles.
+    [[nodiscard]] MeshView read_vertices(uint32_t first, uint32_t count);
+    [[nodiscard]] MeshView read_triangles(uint32_t first, uint32_t count);
+    // hash of the file path and content, read in chunks
+    [[nodiscard]] uint64_t hash();
+};
+
+}// namespace luisa::render
@@ -0,0 +1,185 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <fstream>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif !defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include <nlohmann/json.hpp>
+
+#include "logging.h"
+#include "profiler.h"
+
+namespace luisa {
+
+// peak resident set size of the process since the last reset, in bytes
+[[nodiscard]] static uint64_t peak_rss() noexcept {
+#if defined(__linux__)
+    std::ifstream f{"/proc/self/status"};
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.starts_with("VmHWM:")) {
+            return std::stoull(line.substr(6u)) * 1024u;
+        }
+    }
+    return 0u;
+#elif defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) { return 0u; }
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0u; }
+#ifdef __APPLE__
+    return usage.ru_maxrss;// in bytes
+#else
+    return usage.ru_maxrss * 1024u;// in kilobytes
+#endif
+#endif
+}
+
+// resets the peak to the current RSS, only supported on Linux
+static void reset_peak_rss() noexcept {
+#ifdef __linux__
+    std::ofstream{"/proc/self/clear_refs"} << "5";
+#endif
+}
+
+bool Profiler::supports_stage_peak_rss() noexcept {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+Profiler::Profiler(bool track_peak_rss, bool reset_peak_rss) noexcept
+    : _start{std::chrono::steady_clock::now()},
+      _track_peak_rss{track_peak_rss},
+      _reset_peak_rss{track_peak_rss && reset_peak_rss} {}
+
+bool Profiler::measures_stage_peak_rss() const noexcept {
+    return _reset_peak_rss && supports_stage_peak_rss();
+}
+
+void Profiler::_update_active_peaks() noexcept {
+    if (!_track_peak_rss) { return; }
+    auto peak = peak_rss();
+    for (auto i : _active) {
+        _stages[i].peak_rss = std::max(_stages[i].peak_rss, peak);
+    }
+}
+
+Profiler::Scope::Scope(Profiler *profiler, size_t index) noexcept
+    : _profiler{profiler},
+      _index{index},
+      _bytes_at_start{profiler->_bytes_written.load()},
+      _start{std::chrono::steady_clock::now()} {}
+
+Profiler::Scope::~Scope() noexcept {
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+    std::scoped_lock lock{_profiler->_mutex};
+    _profiler->_update_active_peaks();
+    auto &stage = _profiler->_stages[_index];
+    stage.seconds = seconds;
+    stage.bytes_written = _profiler->_bytes_written.load() - _bytes_at_start;
+    expect(!_profiler->_active.empty() && _profiler->_active.back() == _index,
+           "Profiler stage '{}' closed out of order.", stage.name);
+    _profiler->_active.pop_back();
+}
+
+Profiler::Scope Profiler::scope(std::string name) noexcept {
+    std::scoped_lock lock{_mutex};
+    // fold the peak so far into the enclosing stages before resetting it
+    _update_active_peaks();
+    if (_reset_peak_rss) { reset_peak_rss(); }
+    auto index = _stages.size();
+    _stages.emplace_back(Stage{.name = std::move(name),
+                               .depth = static_cast<uint32_t>(_active.size())});
+    _active.emplace_back(index);
+    return Scope{this, index};
+}
+
+size_t Profiler::accumulated_stage(std::string name) noexcept {
+    std::scoped_lock lock{_mutex};
+    auto index = _stages.size();
+    _stages.emplace_back(Stage{.name = std::move(name),
+                               .depth = static_cast<uint32_t>(_active.size()),
+                               .accumulated = true});
+    return index;
+}
+
+void Profiler::accumulate(size_t stage, double seconds, uint64_t bytes_written) noexcept {
+    std::scoped_lock lock{_mutex};
+    auto &s = _stages[stage];
+    expect(s.accumulated, "Profiler stage '{}' is not an accumulated stage.", s.name);
+    s.seconds += seconds;
+    s.bytes_written += bytes_written;
+    s.count++;
+}
+
+void Profiler::add_bytes_written(uint64_t bytes) noexcept {
+    _bytes_written.fetch_add(bytes);
+}
+
+std::vector<Profiler::Stage> Profiler::stages() const noexcept {
+    std::scoped_lock lock{_mutex};
+    return _stages;
+}
+
+void Profiler::print_summary() const noexcept {
+    auto stages = this->stages();
+    constexpr auto mb = 1. / (1024. * 1024.);
+    println("{:<40} {:>12} {:>14} {:>14}", "Stage", "Time (s)", "Written (MB)", "Peak RSS (MB)");
+    for (auto &&s : stages) {
+        auto name = luisa::format("{:{}}{}{}", "", s.depth * 2u, s.name,
+                                  s.accumulated ? luisa::format(" [{} tasks]", s.count) : "");
+        println("{:<40} {:>12.3f} {:>14.2f} {:>14}", name, s.seconds, s.bytes_written * mb,
+                s.accumulated || s.peak_rss == 0u ? "-" : luisa::format("{:.2f}", s.peak_rss * mb));
+    }
+    println("Peak RSS is {}; the time of stages with tasks is summed over all worker threads.",
+            measures_stage_peak_rss() ?
+                "measured per stage" :
+                "the process peak since start at the end of each stage");
+}
+
+nlohmann::json Profiler::report() const noexcept {
+    auto stages = nlohmann::json::array();
+    for (auto &&s : this->stages()) {
+        auto stage = nlohmann::json{{"name", s.name},
+                                    {"depth", s.depth},
+                                    {"seconds", s.seconds},
+                                    {"bytes_written", s.bytes_written}};
+        if (s.accumulated) {
+            stage["tasks"] = s.count;
+        } else if (s.peak_rss != 0u) {
+            stage["peak_rss"] = s.peak_rss;
+        }
+        stages.emplace_back(std::move(stage));
+    }
+    return {{"version", 1},
+            {"peak_rss_per_stage", measures_stage_peak_rss()},
+            {"total_seconds", std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count()},
+            {"stages", std::move(stages)}};
+}
+
+void Profiler::save_report(const std::filesystem::path &file) const {
+    std::ofstream f{file};
+    expect(f.is_open(), "Failed to open profile report {}.", file.generic_string());
+    f << report().dump(4);
+}
+
+}// namespace luisa
@@ -0,0 +1,90 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+#include <nlohmann/json_fwd.hpp>
+
+namespace luisa {
+
+// Collects wall time, bytes written and peak resident memory per stage of the
+// conversion. Scoped stages are opened on the main thread and may nest;
+// accumulated stages sum up the time of tasks that may run on several threads.
+// Peak RSS is process-wide and costs a few system calls per stage, so it is
+// only tracked on request, and never with concurrent conversions. Without a
+// reset, each stage reports the process peak since start as of its end. The
+// peak of each stage on its own needs the process peak reset as the stage
+// starts (Linux only), which the rest of the process sees as well, so that
+// is up to the owner of the process, e.g. the command line front end.
+class Profiler {
+
+public:
+    struct Stage {
+        std::string name;
+        double seconds{0.};
+        uint64_t bytes_written{0u};
+        uint64_t peak_rss{0u};// 0 if unknown
+        uint64_t count{0u};   // number of tasks, for accumulated stages
+        uint32_t depth{0u};   // nesting level
+        bool accumulated{false};
+    };
+
+    class Scope {
+
+    private:
+        Profiler *_profiler;
+        size_t _index;
+        uint64_t _bytes_at_start;
+        std::chrono::steady_clock::time_point _start;
+
+    private:
+        friend class Profiler;
+        Scope(Profiler *profiler, size_t index) noexcept;
+
+    public:
+        Scope(Scope &&) noexcept = delete;
+        Scope(const Scope &) noexcept = delete;
+        ~Scope() noexcept;
+    };
+
+private:
+    mutable std::mutex _mutex;
+    std::vector<Stage> _stages;
+    std::vector<size_t> _active;// stack of open scoped stages
+    std::atomic<uint64_t> _bytes_written{0u};
+    std::chrono::steady_clock::time_point _start;
+    bool _track_peak_rss;
+    bool _reset_peak_rss;
+
+private:
+    void _update_active_peaks() noexcept;
+
+public:
+    explicit Profiler(bool track_peak_rss = false, bool reset_peak_rss = false) noexcept;
+    // whether peak RSS can be measured per stage, or only for the whole process so far
+    [[nodiscard]] static bool supports_stage_peak_rss() noexcept;
+    // whether each stage reports its own peak, which needs the process peak reset
+    [[nodiscard]] bool measures_stage_peak_rss() const noexcept;
+    [[nodiscard]] Scope scope(std::string name) noexcept;
+    // registers an accumulated stage nested in the current scope, returns its handle
+    [[nodiscard]] size_t accumulated_stage(std::string name) noexcept;
+    // thread-safe
+    void accumulate(size_t stage, double seconds, uint64_t bytes_written = 0u) noexcept;
+    void add_bytes_written(uint64_t bytes) noexcept;
+    [[nodiscard]] std::vector<Stage> stages() const noexcept;
+    void print_summary() const noexcept;
+    [[nodiscard]] nlohmann::json report() const noexcept;
+    void save_report(const std::filesystem::path &file) const;
+};
+
+}// namespace luisa
@@ -0,0 +1,81 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include "logging.h"
+#include "scene_writer.h"
+#include "scene_graph.h"
+
+namespace luisa::render {
+
+uint32_t StringTable::intern(std::string_view s) {
+    if (auto iter = _indices.find(s); iter != _indices.end()) { return iter->second; }
+    auto index = static_cast<uint32_t>(_strings.size());
+    auto &stored = _strings.emplace_back(s);
+    _indices.emplace(stored, index);
+    return index;
+}
+
+std::optional<uint32_t> StringTable::find(std::string_view s) const noexcept {
+    if (auto iter = _indices.find(s); iter != _indices.end()) { return iter->second; }
+    return std::nullopt;
+}
+
+[[nodiscard]] static NodeKind node_kind(const nlohmann::json &node) noexcept {
+    auto type = node.find("type");
+    if (type == node.end() || !type->is_string()) { return NodeKind::Other; }
+    auto &&t = type->get_ref<const std::string &>();
+    if (t == "Shape") { return NodeKind::Shape; }
+    if (t == "Surface") { return NodeKind::Surface; }
+    if (t == "Texture") { return NodeKind::Texture; }
+    if (t == "Light") { return NodeKind::Light; }
+    if (t == "Environment") { return NodeKind::Environment; }
+    return NodeKind::Other;
+}
+
+NodeHandle SceneGraph::add(std::string_view name, nlohmann::json node) {
+    auto name_index = _names.intern(name);
+    auto handle = static_cast<NodeHandle>(_node_values.size());
+    expect(_name_nodes.emplace(name_index, handle).second, "Duplicate scene node {}.", name);
+    auto kind = node_kind(node);
+    _node_names.emplace_back(name_index);
+    _node_kinds.emplace_back(kind);
+    _node_values.emplace_back(std::move(node));
+    _node_removed.emplace_back(false);
+    _node_replacements.emplace_back(handle);
+    _kind_nodes[static_cast<size_t>(kind)].emplace_back(handle);
+    return handle;
+}
+
+std::optional<NodeHandle> SceneGraph::find(std::string_view name) const noexcept {
+    if (auto name_index = _names.find(name)) {
+        if (auto iter = _name_nodes.find(*name_index); iter != _name_nodes.end()) { return iter->second; }
+    }
+    return std::nullopt;
+}
+
+void SceneGraph::replace(NodeHandle node, NodeHandle by) noexcept {
+    _node_removed[node] = true;
+    _node_replacements[node] = by;
+}
+
+NodeHandle SceneGraph::resolve(NodeHandle node) const noexcept {
+    while (_node_replacements[node] != node) { node = _node_replacements[node]; }
+    return node;
+}
+
+std::vector<NodeHandle> SceneGraph::references(NodeHandle node) const {
+    std::vector<NodeHandle> handles;
+    for_each_reference(_node_values[node], [&](const std::string &s) {
+        if (auto h = find(std::string_view{s}.substr(1u))) { handles.emplace_back(*h); }
+    });
+    return handles;
+}
+
+void SceneGraph::serialize(SceneWriter &writer) const {
+    for (auto node = 0u; node < _node_values.size(); node++) {
+        if (!_node_removed[node]) { writer.write(name(node), _node_values[node]); }
+    }
+}
+
+}// namespace luisa::render
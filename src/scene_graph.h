@@ -0,0 +1,116 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <array>
+#include <deque>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+
+namespace luisa::render {
+
+class SceneWriter;
+
+// Interned strings, referred to by dense indices. The strings never move.
+class StringTable {
+
+private:
+    std::deque<std::string> _strings;
+    std::unordered_map<std::string_view, uint32_t> _indices;
+
+public:
+    [[nodiscard]] uint32_t intern(std::string_view s);
+    [[nodiscard]] std::optional<uint32_t> find(std::string_view s) const noexcept;
+    [[nodiscard]] auto &operator[](uint32_t index) const noexcept { return _strings[index]; }
+    [[nodiscard]] auto size() const noexcept { return _strings.size(); }
+};
+
+// by the "type" of the nodes
+enum struct NodeKind : uint8_t {
+    Shape,
+    Surface,
+    Texture,
+    Light,
+    Environment,
+    Other,
+};
+
+inline constexpr auto node_kind_count = static_cast<size_t>(NodeKind::Other) + 1u;
+
+// index of a node in the SceneGraph
+using NodeHandle = uint32_t;
+
+// Call f(s) for each string s = "@<name>" in the value, i.e., each reference
+// to another node; the second overload allows rewriting the references.
+template<typename F>
+void for_each_reference(const nlohmann::json &value, F &&f) {
+    if (auto s = value.get_ptr<const std::string *>()) {
+        if (s->starts_with('@')) { f(*s); }
+    } else if (value.is_structured()) {
+        for (auto &&v : value) { for_each_reference(v, f); }
+    }
+}
+
+template<typename F>
+void for_each_reference(nlohmann::json &value, F &&f) {
+    if (auto s = value.get_ptr<std::string *>()) {
+        if (s->starts_with('@')) { f(*s); }
+    } else if (value.is_structured()) {
+        for (auto &&v : value) { for_each_reference(v, f); }
+    }
+}
+
+// The part of the converted scene that the passes work on, i.e., the textures,
+// surfaces and lights of <name>.exported.* before they are serialized. The
+// shapes, objects and instances, which may number millions, are not kept: they
+// are written as they are converted, after the graph. The nodes are stored as
+// parallel arrays indexed by handle, with the names interned, so that passes
+// over the whole graph work on integers and can look up the nodes by kind.
+// The node contents stay JSON values, as their properties are defined by the
+// renderer plugins; nested nodes are not separate nodes.
+class SceneGraph {
+
+private:
+    StringTable _names;
+    std::vector<uint32_t> _node_names;// into _names
+    std::vector<NodeKind> _node_kinds;
+    std::vector<nlohmann::json> _node_values;
+    std::vector<uint8_t> _node_removed;
+    std::vector<NodeHandle> _node_replacements;// the node itself if not replaced
+    // name index -> node
+    std::unordered_map<uint32_t, NodeHandle> _name_nodes;
+    std::array<std::vector<NodeHandle>, node_kind_count> _kind_nodes;
+
+public:
+    // throws if a node of the same name exists
+    NodeHandle add(std::string_view name, nlohmann::json node);
+    [[nodiscard]] std::optional<NodeHandle> find(std::string_view name) const noexcept;
+    [[nodiscard]] auto size() const noexcept { return _node_values.size(); }
+    [[nodiscard]] auto &name(NodeHandle node) const noexcept { return _names[_node_names[node]]; }
+    [[nodiscard]] auto kind(NodeHandle node) const noexcept { return _node_kinds[node]; }
+    [[nodiscard]] auto &node(NodeHandle node) noexcept { return _node_values[node]; }
+    [[nodiscard]] auto &node(NodeHandle node) const noexcept { return _node_values[node]; }
+    // the nodes of a kind, in the order they were added
+    [[nodiscard]] auto &nodes(NodeKind kind) const noexcept { return _kind_nodes[static_cast<size_t>(kind)]; }
+    // removed nodes keep their handles, but are not serialized
+    void remove(NodeHandle node) noexcept { _node_removed[node] = true; }
+    [[nodiscard]] bool removed(NodeHandle node) const noexcept { return _node_removed[node]; }
+    // removes `node` in favour of `by`, which references to `node` should use instead
+    void replace(NodeHandle node, NodeHandle by) noexcept;
+    // the node that replaced `node`, following chains of replacements, or `node` itself
+    [[nodiscard]] NodeHandle resolve(NodeHandle node) const noexcept;
+    // the nodes referred to by "@<name>" strings in the node; references to unknown names are skipped
+    [[nodiscard]] std::vector<NodeHandle> references(NodeHandle node) const;
+    // writes the nodes that are not removed in the order they were added
+    void serialize(SceneWriter &writer) const;
+};
+
+}// namespace luisa::render
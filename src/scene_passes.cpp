@@ -0,0 +1,186 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <vector>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <unordered_map>
+
+#include "hash.h"
+#include "scene_passes.h"
+
+namespace luisa::render {
+
+// the channels of a texture that evaluates to a constant, or nullopt
+[[nodiscard]] static std::optional<std::vector<double>> evaluate_constant_texture(const SceneGraph &graph,
+                                                                                  const nlohmann::json &texture,
+                                                                                  uint32_t depth = 0u) {
+    // references form a DAG, but a malformed scene must not recurse forever
+    if (depth > 64u) { return std::nullopt; }
+    if (auto s = texture.get_ptr<const std::string *>(); s != nullptr && s->starts_with('@')) {
+        auto node = graph.find(std::string_view{*s}.substr(1u));
+        if (!node || graph.removed(*node) || graph.kind(*node) != NodeKind::Texture) { return std::nullopt; }
+        return evaluate_constant_texture(graph, graph.node(*node), depth + 1u);
+    }
+    auto impl = texture.find("impl");
+    auto prop = texture.find("prop");
+    if (!texture.is_object() || impl == texture.end() || !impl->is_string() ||
+        prop == texture.end() || !prop->is_object()) {
+        return std::nullopt;
+    }
+    auto input = [&](const char *key) -> std::optional<std::vector<double>> {
+        auto iter = prop->find(key);
+        if (iter == prop->end()) { return std::nullopt; }
+        return evaluate_constant_texture(graph, *iter, depth + 1u);
+    };
+    auto &&type = impl->get_ref<const std::string &>();
+    if (type == "Constant") {
+        // other properties than the value may change its meaning, so those are left alone
+        auto v = prop->find("v");
+        if (v == prop->end() || prop->size() != 1u) { return std::nullopt; }
+        if (v->is_number()) { return std::vector{v->get<double>()}; }
+        if (!v->is_array() || v->empty() || v->size() > 4u ||
+            !std::all_of(v->cbegin(), v->cend(), [](auto &&x) { return x.is_number(); })) {
+            return std::nullopt;
+        }
+        return v->get<std::vector<double>>();
+    }
+    if (type == "Multiply" && prop->size() == 2u) {
+        auto a = input("a");
+        auto b = input("b");
+        if (!a || !b || a->size() != b->size()) { return std::nullopt; }
+        for (auto i = 0u; i < a->size(); i++) { (*a)[i] *= (*b)[i]; }
+        return a;
+    }
+    if (type == "Scale" && prop->size() == 2u) {
+        auto base = input("base");
+        auto scale = prop->find("scale");
+        if (!base || scale == prop->end()) { return std::nullopt; }
+        if (scale->is_number()) {
+            for (auto &&x : *base) { x *= scale->get<double>(); }
+            return base;
+        }
+        if (!scale->is_array() || scale->size() != base->size() ||
+            !std::all_of(scale->cbegin(), scale->cend(), [](auto &&x) { return x.is_number(); })) {
+            return std::nullopt;
+        }
+        for (auto i = 0u; i < base->size(); i++) { (*base)[i] *= (*scale)[i].get<double>(); }
+        return base;
+    }
+    if (type == "Concat" && prop->size() == 1u) {
+        auto channels = prop->find("channels");
+        if (channels == prop->end() || !channels->is_array()) { return std::nullopt; }
+        std::vector<double> values;
+        for (auto &&c : *channels) {
+            auto v = evaluate_constant_texture(graph, c, depth + 1u);
+            if (!v) { return std::nullopt; }
+            values.insert(values.end(), v->cbegin(), v->cend());
+        }
+        if (values.empty() || values.size() > 4u) { return std::nullopt; }
+        return values;
+    }
+    return std::nullopt;
+}
+
+size_t fold_constant_textures(SceneGraph &graph) {
+    auto folded_count = size_t{0u};
+    // Replaces the textures in the value that evaluate to constants, outermost first. Only
+    // objects are replaced, so references to constant Texture nodes stay as they are.
+    auto fold = [&](auto &self, nlohmann::json &value) -> void {
+        if (value.is_object()) {
+            if (auto impl = value.find("impl");
+                impl != value.end() && impl->is_string() &&
+                (*impl == "Multiply" || *impl == "Scale" || *impl == "Concat")) {
+                if (auto v = evaluate_constant_texture(graph, value)) {
+                    value["impl"] = "Constant";
+                    value["prop"] = {{"v", std::move(*v)}};
+                    folded_count++;
+                    return;
+                }
+            }
+        }
+        if (value.is_structured()) {
+            for (auto &&v : value) { self(self, v); }
+        }
+    };
+    for (auto kind : {NodeKind::Texture, NodeKind::Surface, NodeKind::Light, NodeKind::Environment}) {
+        for (auto node : graph.nodes(kind)) {
+            if (!graph.removed(node)) { fold(fold, graph.node(node)); }
+        }
+    }
+    return folded_count;
+}
+
+size_t merge_identical_nodes(SceneGraph &graph) {
+    auto merged_count = size_t{0u};
+    // Textures are merged before the surfaces using them. A merge can make the nodes referring
+    // to the merged ones identical in turn, e.g. Mix surfaces, so the rounds repeat until none
+    // merges anything; the values compare equal by content, as JSON objects are sorted by key.
+    for (auto merged = true; merged;) {
+        merged = false;
+        // removed node -> the identical node kept
+        std::unordered_map<NodeHandle, NodeHandle> replacements;
+        for (auto kind : {NodeKind::Texture, NodeKind::Surface}) {
+            std::unordered_map<uint64_t, std::vector<NodeHandle>> groups;
+            for (auto node : graph.nodes(kind)) {
+                if (graph.removed(node)) { continue; }
+                auto &value = graph.node(node);
+                auto &candidates = groups[hash64(value.dump())];
+                if (auto iter = std::find_if(candidates.cbegin(), candidates.cend(), [&](auto c) {
+                        return graph.node(c) == value;
+                    });
+                    iter != candidates.cend()) {
+                    replacements.emplace(node, *iter);
+                    graph.replace(node, *iter);
+                } else {
+                    candidates.emplace_back(node);
+                }
+            }
+            if (replacements.empty()) { continue; }
+            // rewrite the references to the removed nodes before the next kind is compared
+            for (auto node = 0u; node < graph.size(); node++) {
+                if (graph.removed(node)) { continue; }
+                for_each_reference(graph.node(node), [&](std::string &s) {
+                    if (auto h = graph.find(std::string_view{s}.substr(1u))) {
+                        if (auto iter = replacements.find(*h); iter != replacements.end()) {
+                            s = "@" + graph.name(iter->second);
+                        }
+                    }
+                });
+            }
+            merged_count += replacements.size();
+            replacements.clear();
+            merged = true;
+        }
+    }
+    return merged_count;
+}
+
+size_t remove_unreachable_nodes(SceneGraph &graph, const nlohmann::json &roots) {
+    std::vector<uint8_t> reached(graph.size(), false);
+    std::vector<NodeHandle> stack;
+    auto visit = [&](const std::string &s) {
+        if (auto h = graph.find(std::string_view{s}.substr(1u)); h && !reached[*h]) {
+            reached[*h] = true;
+            stack.emplace_back(*h);
+        }
+    };
+    for_each_reference(roots, visit);
+    while (!stack.empty()) {
+        auto node = stack.back();
+        stack.pop_back();
+        for_each_reference(std::as_const(graph).node(node), visit);
+    }
+    auto removed_count = size_t{0u};
+    for (auto node = 0u; node < graph.size(); node++) {
+        if (!reached[node] && !graph.removed(node)) {
+            graph.remove(node);
+            removed_count++;
+        }
+    }
+    return removed_count;
+}
+
+}// namespace luisa::render
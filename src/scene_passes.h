@@ -0,0 +1,29 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <cstddef>
+
+#include "scene_graph.h"
+
+namespace luisa::render {
+
+// Passes over the whole scene graph, run after all nodes are converted.
+
+// Evaluates the texture subgraphs whose inputs are all constant, i.e., Multiply,
+// Scale and Concat textures of Constant ones, inline or referenced, and replaces
+// them with single Constant textures. Returns the number of textures replaced.
+size_t fold_constant_textures(SceneGraph &graph);
+
+// Merges Surface and Texture nodes that are identical once their references are
+// merged, replacing all but the first of each group by it (see SceneGraph::resolve())
+// and rewriting the references to the replaced ones. Returns the number of nodes removed.
+size_t merge_identical_nodes(SceneGraph &graph);
+
+// Removes the nodes that cannot be reached by following references from the
+// ones in `roots`, e.g. the render settings. Returns the number of nodes removed.
+size_t remove_unreachable_nodes(SceneGraph &graph, const nlohmann::json &roots);
+
+}// namespace luisa::render
@@ -0,0 +1,24 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include "scene_sink.h"
+
+namespace luisa::render {
+
+void MemorySceneSink::on_node(std::string_view name, const nlohmann::json &node) {
+    _scene.nodes.emplace_back(name, node);
+}
+
+void MemorySceneSink::on_mesh(std::string_view file, const MeshView &mesh) {
+    auto buffers = copy_mesh(mesh);
+    std::scoped_lock lock{_mutex};
+    _scene.meshes.insert_or_assign(std::string{file}, std::move(buffers));
+}
+
+void MemorySceneSink::on_finish(const nlohmann::json &render, const nlohmann::json &stats) {
+    _scene.render = render;
+    _scene.stats = stats;
+}
+
+}// namespace luisa::render
@@ -0,0 +1,57 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <utility>
+#include <string_view>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+
+#include "mesh_view.h"
+
+namespace luisa::render {
+
+// Receives a scene converted in process instead of it being written to disk.
+// The nodes are those of <name>.exported.*, the meshes those of lr_exported_meshes.
+class SceneSink {
+public:
+    virtual ~SceneSink() noexcept = default;
+    // a named node, in dependency order, on the converting thread
+    virtual void on_node(std::string_view name, const nlohmann::json &node) = 0;
+    // A triangle mesh, named like the "file" property of the Mesh nodes referring to it.
+    // Called on the worker threads, possibly concurrently, as soon as the mesh is
+    // converted; the view is only valid during the call.
+    virtual void on_mesh(std::string_view file, const MeshView &mesh) = 0;
+    // the render settings, whose shapes refer to the "renderable" node, and the scene
+    // statistics (see SceneStats), after all nodes and meshes
+    virtual void on_finish(const nlohmann::json &render, const nlohmann::json &stats) = 0;
+};
+
+struct ConvertedScene {
+    std::vector<std::pair<std::string, nlohmann::json>> nodes;
+    std::unordered_map<std::string, MeshBuffers> meshes;
+    nlohmann::json render;
+    nlohmann::json stats;
+};
+
+// Gathers the converted scene, copying the meshes.
+class MemorySceneSink final : public SceneSink {
+
+private:
+    ConvertedScene _scene;
+    std::mutex _mutex;
+
+public:
+    void on_node(std::string_view name, const nlohmann::json &node) override;
+    void on_mesh(std::string_view file, const MeshView &mesh) override;
+    void on_finish(const nlohmann::json &render, const nlohmann::json &stats) override;
+    [[nodiscard]] ConvertedScene take() noexcept { return std::move(_scene); }
+};
+
+}// namespace luisa::render
@@ -0,0 +1,108 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include "logging.h"
+#include "scene_stats.h"
+
+namespace luisa::render {
+
+MeshStats MeshStats::of(const MeshView &mesh) noexcept {
+    return {.num_vertices = mesh.num_vertices,
+            .num_triangles = mesh.num_triangles,
+            .has_normals = static_cast<bool>(mesh.N),
+            .has_uvs = static_cast<bool>(mesh.uv)};
+}
+
+uint64_t MeshStats::vertex_buffer_bytes() const noexcept {
+    auto vertex_size = 3u * sizeof(float) +
+                       (has_normals ? 3u * sizeof(float) : 0u) +
+                       (has_uvs ? 2u * sizeof(float) : 0u);
+    return static_cast<uint64_t>(num_vertices) * vertex_size;
+}
+
+uint64_t MeshStats::index_buffer_bytes() const noexcept {
+    return static_cast<uint64_t>(num_triangles) * 3u * sizeof(uint32_t);
+}
+
+void SceneStats::add_mesh(std::vector<std::string> files, const MeshStats &stats, uint64_t placements) {
+    _meshes.emplace_back(Mesh{.files = std::move(files), .stats = stats, .placements = placements});
+}
+
+void SceneStats::add_material_use(const std::string &material, uint64_t placements) {
+    _material_uses[material] += placements;
+}
+
+void SceneStats::set_textures(uint64_t count, uint64_t bytes) noexcept {
+    _texture_count = count;
+    _texture_bytes = bytes;
+}
+
+uint64_t SceneStats::unique_triangles() const noexcept {
+    auto n = uint64_t{0u};
+    for (auto &&m : _meshes) { n += m.stats.num_triangles; }
+    return n;
+}
+
+uint64_t SceneStats::instanced_triangles() const noexcept {
+    auto n = uint64_t{0u};
+    for (auto &&m : _meshes) { n += m.stats.num_triangles * m.placements; }
+    return n;
+}
+
+uint64_t SceneStats::geometry_bytes() const noexcept {
+    auto n = uint64_t{0u};
+    for (auto &&m : _meshes) { n += m.stats.vertex_buffer_bytes() + m.stats.index_buffer_bytes(); }
+    return n;
+}
+
+nlohmann::json SceneStats::report() const {
+    auto meshes = nlohmann::json::array();
+    auto vertices = uint64_t{0u};
+    auto placed_vertices = uint64_t{0u};
+    auto placements = uint64_t{0u};
+    auto vertex_buffer_bytes = uint64_t{0u};
+    auto index_buffer_bytes = uint64_t{0u};
+    for (auto &&m : _meshes) {
+        vertices += m.stats.num_vertices;
+        placed_vertices += m.stats.num_vertices * m.placements;
+        placements += m.placements;
+        vertex_buffer_bytes += m.stats.vertex_buffer_bytes();
+        index_buffer_bytes += m.stats.index_buffer_bytes();
+        meshes.emplace_back(nlohmann::json{{"files", m.files},
+                                           {"vertices", m.stats.num_vertices},
+                                           {"triangles", m.stats.num_triangles},
+                                           {"normals", m.stats.has_normals},
+                                           {"uvs", m.stats.has_uvs},
+                                           {"placements", m.placements},
+                                           {"vertex_buffer_bytes", m.stats.vertex_buffer_bytes()},
+                                           {"index_buffer_bytes", m.stats.index_buffer_bytes()}});
+    }
+    return {{"version", 1},
+            {"totals",
+             {{"meshes", _meshes.size()},
+              {"mesh_placements", placements},
+              {"analytic_shapes", _analytic_shapes},
+              {"unique_vertices", vertices},
+              {"instanced_vertices", placed_vertices},
+              {"unique_triangles", unique_triangles()},
+              {"instanced_triangles", instanced_triangles()},
+              {"vertex_buffer_bytes", vertex_buffer_bytes},
+              {"index_buffer_bytes", index_buffer_bytes},
+              {"textures", _texture_count},
+              {"texture_bytes", _texture_bytes}}},
+            {"meshes", std::move(meshes)},
+            {"material_uses", _material_uses}};
+}
+
+void SceneStats::save_report(const std::filesystem::path &file) const {
+    std::ofstream f{file};
+    expect(f.is_open(), "Failed to open scene statistics file {}.", file.generic_string());
+    f << report().dump(4);
+}
+
+}// namespace luisa::render
@@ -0,0 +1,67 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+#include <nlohmann/json_fwd.hpp>
+
+#include "mesh_view.h"
+
+namespace luisa::render {
+
+// Vertex and triangle counts of an exported triangle mesh.
+struct MeshStats {
+    uint32_t num_vertices{0u};
+    uint32_t num_triangles{0u};
+    bool has_normals{false};
+    bool has_uvs{false};
+    [[nodiscard]] static MeshStats of(const MeshView &mesh) noexcept;
+    // estimated GPU buffer sizes: float3 positions and normals, float2 uvs, uint3 triangles
+    [[nodiscard]] uint64_t vertex_buffer_bytes() const noexcept;
+    [[nodiscard]] uint64_t index_buffer_bytes() const noexcept;
+};
+
+// Estimates what rendering a converted scene costs, so that it can be scheduled
+// on machines with enough memory without a trial render. Meshes are counted
+// once as stored and once per placement, i.e. per visible shape or instance
+// drawing them. Saved next to the scene as <name>.stats.json.
+class SceneStats {
+
+private:
+    struct Mesh {
+        std::vector<std::string> files;
+        MeshStats stats;
+        uint64_t placements{0u};
+    };
+
+private:
+    std::vector<Mesh> _meshes;
+    uint64_t _analytic_shapes{0u};
+    // material node name, as exported, -> placements of the shapes using it, ordered for stable output
+    std::map<std::string, uint64_t> _material_uses;
+    uint64_t _texture_count{0u};
+    uint64_t _texture_bytes{0u};
+
+public:
+    // a mesh written once (possibly split into several files) and drawn `placements` times
+    void add_mesh(std::vector<std::string> files, const MeshStats &stats, uint64_t placements);
+    void add_analytic_shape(uint64_t placements) noexcept { _analytic_shapes += placements; }
+    void add_material_use(const std::string &material, uint64_t placements);
+    // texture sizes are those of the image files, as decoded sizes are unknown for most formats
+    void set_textures(uint64_t count, uint64_t bytes) noexcept;
+    [[nodiscard]] uint64_t unique_triangles() const noexcept;
+    [[nodiscard]] uint64_t instanced_triangles() const noexcept;
+    [[nodiscard]] uint64_t geometry_bytes() const noexcept;
+    [[nodiscard]] uint64_t texture_bytes() const noexcept { return _texture_bytes; }
+    [[nodiscard]] nlohmann::json report() const;
+    void save_report(const std::filesystem::path &file) const;
+};
+
+}// namespace luisa::render
@@ -0,0 +1,141 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <limits>
+
+#include <nlohmann/json.hpp>
+
+#include "hash.h"
+#include "cache.h"
+#include "logging.h"
+#include "scene_sink.h"
+#include "scene_writer.h"
+
+namespace luisa::render {
+
+// flush to disk in chunks of this size
+static constexpr auto scene_writer_buffer_size = 4u * 1024u * 1024u;
+
+std::string_view scene_format_extension(SceneFormat format) noexcept {
+    switch (format) {
+        case SceneFormat::JSON:
+        case SceneFormat::CompactJSON: return "json";
+        case SceneFormat::CBOR: return "cbor";
+        case SceneFormat::MessagePack: return "msgpack";
+        case SceneFormat::UBJSON: return "ubj";
+    }
+    panic("Invalid scene format.");
+}
+
+SceneWriter::SceneWriter(const std::filesystem::path &base_dir, std::string file_name, SceneFormat format)
+    : _base_dir{base_dir},
+      _file_name{std::move(file_name)},
+      _format{format},
+      _temp_path{base_dir / luisa::format("{}.tmp", _file_name)},
+      _file{std::make_unique<AsyncFileWriter>(_temp_path)} {
+    expect(_file->is_open(), "Failed to open scene file {}.", _temp_path.generic_string());
+    _buffer.reserve(scene_writer_buffer_size);
+    // the binary formats open the top-level map without a size where possible
+    switch (_format) {
+        case SceneFormat::JSON:
+        case SceneFormat::CompactJSON:
+        case SceneFormat::UBJSON: _buffer.push_back('{'); break;
+        case SceneFormat::CBOR: _buffer.push_back('\xbf'); break;          // indefinite-length map
+        case SceneFormat::MessagePack: _buffer.append("\xdf\0\0\0\0", 5u); break;// map 32, size patched in finish()
+    }
+}
+
+SceneWriter::SceneWriter(SceneSink &sink, std::string file_name) noexcept
+    : _file_name{std::move(file_name)}, _format{SceneFormat::JSON}, _sink{&sink} {}
+
+SceneWriter::~SceneWriter() noexcept {
+    if (_file != nullptr && _file->is_open()) {// not finished
+        static_cast<void>(_file->close());
+        std::error_code ec;
+        std::filesystem::remove(_temp_path, ec);
+    }
+}
+
+void SceneWriter::_flush() {
+    _hash = hash64(_buffer, _hash);
+    _bytes_written += _buffer.size();
+    _buffer = _file->submit(std::move(_buffer));
+}
+
+void SceneWriter::write(std::string_view name, const nlohmann::json &node) {
+    auto first = _count++ == 0u;
+    if (_sink != nullptr) {
+        _sink->on_node(name, node);
+        return;
+    }
+    switch (_format) {
+        case SceneFormat::JSON: {
+            // same layout as nlohmann::json::dump(4) of the enclosing object
+            _buffer.append(first ? "\n    " : ",\n    ");
+            _buffer.append(nlohmann::json(name).dump()).append(": ");
+            auto s = node.dump(4);
+            for (auto c : s) {
+                _buffer.push_back(c);
+                if (c == '\n') { _buffer.append("    "); }
+            }
+            break;
+        }
+        case SceneFormat::CompactJSON: {
+            if (!first) { _buffer.push_back(','); }
+            _buffer.append(nlohmann::json(name).dump()).push_back(':');
+            _buffer.append(node.dump());
+            break;
+        }
+        case SceneFormat::CBOR: {
+            nlohmann::json::to_cbor(name, _buffer);
+            nlohmann::json::to_cbor(node, _buffer);
+            break;
+        }
+        case SceneFormat::MessagePack: {
+            nlohmann::json::to_msgpack(name, _buffer);
+            nlohmann::json::to_msgpack(node, _buffer);
+            break;
+        }
+        case SceneFormat::UBJSON: {
+            // object keys are strings without the 'S' marker
+            auto key = nlohmann::json::to_ubjson(name);
+            _buffer.append(reinterpret_cast<const char *>(key.data() + 1), key.size() - 1u);
+            nlohmann::json::to_ubjson(node, _buffer);
+            break;
+        }
+    }
+    if (_buffer.size() >= scene_writer_buffer_size) { _flush(); }
+}
+
+void SceneWriter::finish(ConversionCache &cache) {
+    if (_sink != nullptr) { return; }
+    switch (_format) {
+        case SceneFormat::JSON: _buffer.append(_count == 0u ? "}" : "\n}"); break;
+        case SceneFormat::CompactJSON:
+        case SceneFormat::UBJSON: _buffer.push_back('}'); break;
+        case SceneFormat::CBOR: _buffer.push_back('\xff'); break;
+        case SceneFormat::MessagePack: break;
+    }
+    _flush();
+    if (_format == SceneFormat::MessagePack) {
+        expect(_count <= std::numeric_limits<uint32_t>::max(),
+               "Too many nodes ({}) for a MessagePack map.", _count);
+        char size[4]{static_cast<char>(_count >> 24u),
+                     static_cast<char>(_count >> 16u),
+                     static_cast<char>(_count >> 8u),
+                     static_cast<char>(_count)};
+        _file->overwrite(1u, size, sizeof(size));
+    }
+    expect(_file->close(), "Failed to write scene file {}.", _temp_path.generic_string());
+    std::error_code ec;
+    if (cache.is_up_to_date(_file_name, _hash)) {
+        std::filesystem::remove(_temp_path, ec);
+    } else {
+        std::filesystem::rename(_temp_path, _base_dir / _file_name, ec);
+    }
+    expect(!ec, "Failed to write scene file {}: {}.", _file_name, ec.message());
+    cache.record(_file_name, _hash);
+}
+
+}// namespace luisa::render
@@ -0,0 +1,71 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+#include <nlohmann/json_fwd.hpp>
+
+#include "async_file_writer.h"
+
+namespace luisa::render {
+
+class ConversionCache;
+class SceneSink;
+
+enum struct SceneFormat : uint8_t {
+    JSON,       // pretty-printed with an indent of 4
+    CompactJSON,// minified
+    CBOR,
+    MessagePack,
+    UBJSON,
+};
+
+[[nodiscard]] std::string_view scene_format_extension(SceneFormat format) noexcept;
+
+// Writes a scene description file, i.e., an object of named nodes, to disk
+// incrementally as the nodes are produced, so that the whole scene never has
+// to be gathered into one DOM. The content goes to a temporary file that
+// replaces the destination in finish(), unless the cache reports the existing
+// file as up to date. In process, the nodes can be handed to a SceneSink instead.
+class SceneWriter {
+
+private:
+    std::filesystem::path _base_dir;
+    std::string _file_name;
+    SceneFormat _format;
+    std::filesystem::path _temp_path;
+    std::unique_ptr<AsyncFileWriter> _file;// null if writing to the sink
+    SceneSink *_sink{nullptr};
+    std::string _buffer;
+    uint64_t _hash{0u};
+    uint64_t _bytes_written{0u};
+    size_t _count{0u};
+
+private:
+    void _flush();
+
+public:
+    // file_name is relative to base_dir
+    SceneWriter(const std::filesystem::path &base_dir, std::string file_name, SceneFormat format);
+    // passes the nodes on to `sink`; file_name is still reported, but nothing is written
+    SceneWriter(SceneSink &sink, std::string file_name) noexcept;
+    ~SceneWriter() noexcept;
+    SceneWriter(SceneWriter &&) noexcept = delete;
+    SceneWriter(const SceneWriter &) noexcept = delete;
+    [[nodiscard]] auto &file_name() const noexcept { return _file_name; }
+    [[nodiscard]] auto format() const noexcept { return _format; }
+    [[nodiscard]] auto node_count() const noexcept { return _count; }
+    // bytes flushed to the file so far
+    [[nodiscard]] auto bytes_written() const noexcept { return _bytes_written; }
+    void write(std::string_view name, const nlohmann::json &node);
+    void finish(ConversionCache &cache);
+};
+
+}// namespace luisa::render
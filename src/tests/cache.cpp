@@ -0,0 +1,175 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+#include "logging.h"
+#include "cache.h"
+#include "scene_writer.h"
+#include "tests/testing.h"
+
+using namespace luisa::render;
+
+namespace {
+
+void write_file(const std::filesystem::path &path, std::string_view content) {
+    std::ofstream file{path, std::ios::binary};
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    luisa::expect(file.good(), "Failed to write {}.", path.generic_string());
+}
+
+// moves the modification time of a file, as a later write of the same size would
+void touch(const std::filesystem::path &path) {
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds{1});
+}
+
+void test_outputs() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-cache-outputs"};
+    write_file(dir.path() / "a.obj", "a");
+    write_file(dir.path() / "b.obj", "b");
+    {
+        ConversionCache cache{dir.path(), "scene", true};
+        luisa::expect(!cache.is_up_to_date("a.obj", 1u), "Up to date without a manifest.");
+        cache.record("a.obj", 1u);
+        cache.record("b.obj", 2u);
+        // missing outputs are not recorded
+        cache.record("c.obj", 3u);
+        // outputs are only compared against the previous run
+        luisa::expect(!cache.is_up_to_date("a.obj", 1u), "Up to date before the manifest was saved.");
+        cache.save();
+    }
+    {
+        ConversionCache cache{dir.path(), "scene", true};
+        luisa::expect(cache.is_up_to_date("a.obj", 1u), "An unchanged output is not up to date.");
+        luisa::expect(!cache.is_up_to_date("a.obj", 2u), "An output of other inputs is up to date.");
+        luisa::expect(!cache.is_up_to_date("c.obj", 3u), "An unrecorded output is up to date.");
+        // only a.obj is recorded again, so b.obj is forgotten
+        cache.record("a.obj", 1u);
+        cache.save();
+    }
+    {
+        ConversionCache cache{dir.path(), "scene", true};
+        luisa::expect(cache.is_up_to_date("a.obj", 1u), "A recorded output is not up to date.");
+        luisa::expect(!cache.is_up_to_date("b.obj", 2u), "An output not recorded again is up to date.");
+    }
+    // outputs rewritten by something else are not up to date, even with the same size
+    write_file(dir.path() / "a.obj", "x");
+    touch(dir.path() / "a.obj");
+    luisa::expect(!ConversionCache{dir.path(), "scene", true}.is_up_to_date("a.obj", 1u),
+                  "A rewritten output is up to date.");
+    std::filesystem::remove(dir.path() / "a.obj");
+    luisa::expect(!ConversionCache{dir.path(), "scene", true}.is_up_to_date("a.obj", 1u),
+                  "A deleted output is up to date.");
+}
+
+void test_disabled() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-cache-disabled"};
+    write_file(dir.path() / "a.obj", "a");
+    {
+        ConversionCache cache{dir.path(), "scene", true};
+        cache.record("a.obj", 1u);
+        cache.save();
+    }
+    ConversionCache cache{dir.path(), "scene", false};
+    luisa::expect(!cache.is_up_to_date("a.obj", 1u), "A disabled cache reports outputs up to date.");
+    luisa::expect(!cache.find_input(dir.path() / "a.obj"), "A disabled cache reports inputs.");
+    // runs without the cache overwrite the outputs, so the manifest goes
+    cache.remove_manifest();
+    luisa::expect(!std::filesystem::exists(dir.path() / "scene.manifest.json"), "The manifest was kept.");
+}
+
+void test_invalid_manifests() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-cache-invalid"};
+    write_file(dir.path() / "a.obj", "a");
+    {
+        ConversionCache cache{dir.path(), "scene", true};
+        cache.record("a.obj", 1u);
+        cache.save();
+    }
+    auto manifest_file = dir.path() / "scene.manifest.json";
+    auto manifest = [&] {
+        std::ifstream f{manifest_file};
+        return nlohmann::json::parse(f);
+    }();
+    // manifests of other versions and broken ones are ignored
+    auto other_version = manifest;
+    other_version["version"] = ConversionCache::version - 1u;
+    for (auto &&content : {other_version.dump(), manifest.dump().substr(0u, 20u), std::string{"[]"}}) {
+        write_file(manifest_file, content);
+        luisa::expect(!ConversionCache{dir.path(), "scene", true}.is_up_to_date("a.obj", 1u),
+                      "Trusted the manifest {}.", content);
+    }
+    write_file(manifest_file, manifest.dump());
+    luisa::expect(ConversionCache{dir.path(), "scene", true}.is_up_to_date("a.obj", 1u),
+                  "The restored manifest is not trusted.");
+}
+
+void test_inputs() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-cache-inputs"};
+    auto input = dir.path() / "mesh.ply";
+    write_file(input, "mesh");
+    {
+        ConversionCache cache{dir.path(), "scene", true};
+        luisa::expect(!cache.find_input(input), "Found an input without a manifest.");
+        // facts recorded for the same input, e.g. by several shapes, are merged
+        cache.record_input(input, {{"mesh_hash", "01"}});
+        cache.record_input(input, {{"file_hash", "02"}});
+        cache.save();
+    }
+    auto facts = ConversionCache{dir.path(), "scene", true}.find_input(input);
+    luisa::expect(facts && *facts == nlohmann::json{{"mesh_hash", "01"}, {"file_hash", "02"}},
+                  "Unexpected facts {}.", facts ? facts->dump() : "none");
+    // any change of the size or modification time invalidates the facts
+    touch(input);
+    luisa::expect(!ConversionCache{dir.path(), "scene", true}.find_input(input), "Trusted a touched input.");
+    {
+        ConversionCache cache{dir.path(), "scene", true};
+        cache.record_input(input, {{"mesh_hash", "03"}});
+        cache.save();
+    }
+    write_file(input, "a longer mesh");
+    luisa::expect(!ConversionCache{dir.path(), "scene", true}.find_input(input), "Trusted a rewritten input.");
+    std::filesystem::remove(input);
+    luisa::expect(!ConversionCache{dir.path(), "scene", true}.find_input(input), "Trusted a deleted input.");
+}
+
+// the scene files are only replaced if their content changed, keeping their modification times
+void test_scene_writer() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-cache-scene"};
+    auto write_scene = [&](double value) {
+        ConversionCache cache{dir.path(), "scene", true};
+        SceneWriter writer{dir.path(), "scene.exported.json", SceneFormat::JSON};
+        writer.write("Texture", {{"type", "Texture"}, {"impl", "Constant"}, {"prop", {{"v", value}}}});
+        writer.finish(cache);
+        cache.save();
+        return std::filesystem::last_write_time(dir.path() / "scene.exported.json");
+    };
+    auto first = write_scene(1.);
+    touch(dir.path() / "scene.exported.json");
+    // the touched file is rewritten, and then kept as long as the content is the same
+    auto second = write_scene(1.);
+    luisa::expect(second != first, "The touched scene file was kept.");
+    luisa::expect(write_scene(1.) == second, "The unchanged scene file was rewritten.");
+    luisa::expect(write_scene(2.) != second, "The changed scene file was kept.");
+    std::ifstream f{dir.path() / "scene.exported.json"};
+    luisa::expect(nlohmann::json::parse(f).at("Texture").at("prop").at("v") == 2., "The scene file is stale.");
+    luisa::expect(!std::filesystem::exists(dir.path() / "scene.exported.json.tmp"), "The temporary file was kept.");
+}
+
+}// namespace
+
+int main() {
+    return luisa::test::run_tests({
+        {"outputs", test_outputs},
+        {"disabled", test_disabled},
+        {"invalid manifests", test_invalid_manifests},
+        {"inputs", test_inputs},
+        {"scene writer", test_scene_writer},
+    });
+}
@@ -0,0 +1,116 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+#include <nlohmann/json.hpp>
+
+#include "logging.h"
+#include "mesh_writer.h"
+#include "ply_mesh.h"
+#include "convert.h"
+#include "tests/testing.h"
+
+using namespace luisa::render;
+
+namespace {
+
+// Writes <dir>/scene.pbrt with a single PLY mesh of 2 x n x n triangles.
+void write_scene(const std::filesystem::path &dir, uint32_t n) {
+    dump_mesh_to_binary_ply(dir / "grid.ply", luisa::test::make_grid(n).view());
+    std::ofstream file{dir / "scene.pbrt"};
+    file << "LookAt 0 4 -6  0 0 0  0 1 0\n"
+            "Camera \"perspective\" \"float fov\" [45]\n"
+            "Film \"image\" \"integer xresolution\" [64] \"integer yresolution\" [64] \"string filename\" \"scene.exr\"\n"
+            "WorldBegin\n"
+            "Shape \"plymesh\" \"string filename\" \"grid.ply\"\n"
+            "WorldEnd\n";
+    luisa::expect(file.good(), "Failed to write the scene.");
+}
+
+// the exported scene as JSON
+[[nodiscard]] nlohmann::json read_exported_scene(const std::filesystem::path &dir) {
+    std::ifstream file{dir / "scene.exported.json"};
+    luisa::expect(file.is_open(), "No exported scene.");
+    return nlohmann::json::parse(file);
+}
+
+// the mesh files of the parts the mesh shape was split into, as referenced by the exported scene
+[[nodiscard]] std::vector<std::filesystem::path> exported_parts(const std::filesystem::path &dir) {
+    auto scene = read_exported_scene(dir);
+    auto &shape = scene.at("Shape:0");
+    luisa::expect(shape.at("impl") == "Group", "The mesh was not split: {}.", shape.dump());
+    std::vector<std::filesystem::path> files;
+    for (auto &&part : shape.at("prop").at("shapes")) {
+        auto &&node = scene.at(part.get<std::string>().substr(1u));
+        files.emplace_back(dir / node.at("prop").at("file").get<std::string>());
+    }
+    return files;
+}
+
+// the parts must hold all triangles of the mesh, whatever was written by earlier runs
+void expect_parts_cover(const std::filesystem::path &dir, uint32_t num_triangles) {
+    auto parts = exported_parts(dir);
+    auto total = 0ull;
+    for (auto &&file : parts) {
+        auto part = map_binary_ply_mesh(file);
+        luisa::expect(part != nullptr, "Part {} is missing or invalid.", file.generic_string());
+        total += part->view.num_triangles;
+    }
+    luisa::expect(total == num_triangles, "The {} parts hold {} triangles of {}.", parts.size(), total, num_triangles);
+}
+
+[[nodiscard]] ConvertOptions split_options(uint32_t limit) noexcept {
+    return {.jobs = 2u,
+            .mesh_format = MeshFormat::PLY,
+            .incremental = true,
+            .stream_ply = true,
+            .split_meshes_above = limit};
+}
+
+void test_split_limit_change() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-incremental-split"};
+    write_scene(dir.path(), 64u);
+    auto scene_file = (dir.path() / "scene.pbrt").generic_string();
+    constexpr auto num_triangles = 2u * 64u * 64u;
+    convert(scene_file.c_str(), split_options(1000u));
+    auto fine_parts = exported_parts(dir.path()).size();
+    expect_parts_cover(dir.path(), num_triangles);
+    // fewer, larger parts with the names of the first ones of the previous run
+    convert(scene_file.c_str(), split_options(3000u));
+    luisa::expect(exported_parts(dir.path()).size() < fine_parts, "The larger limit did not change the split.");
+    expect_parts_cover(dir.path(), num_triangles);
+    // and back, with parts of the first run left over from the second
+    convert(scene_file.c_str(), split_options(1000u));
+    luisa::expect(exported_parts(dir.path()).size() == fine_parts, "The split is not reproducible.");
+    expect_parts_cover(dir.path(), num_triangles);
+}
+
+void test_unchanged_split_is_kept() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-incremental-unchanged"};
+    write_scene(dir.path(), 64u);
+    auto scene_file = (dir.path() / "scene.pbrt").generic_string();
+    convert(scene_file.c_str(), split_options(1000u));
+    auto parts = exported_parts(dir.path());
+    std::vector<std::filesystem::file_time_type> times;
+    for (auto &&file : parts) { times.emplace_back(std::filesystem::last_write_time(file)); }
+    convert(scene_file.c_str(), split_options(1000u));
+    luisa::expect(exported_parts(dir.path()) == parts, "The parts changed.");
+    for (auto i = 0u; i < parts.size(); i++) {
+        luisa::expect(std::filesystem::last_write_time(parts[i]) == times[i],
+                      "Rewrote the up-to-date part {}.", parts[i].generic_string());
+    }
+}
+
+}// namespace
+
+int main() {
+    return luisa::test::run_tests({
+        {"split limit change", test_split_limit_change},
+        {"unchanged split is kept", test_unchanged_split_is_kept},
+    });
+}
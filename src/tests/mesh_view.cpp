@@ -0,0 +1,158 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <vector>
+#include <cstring>
+
+#include "logging.h"
+#include "mesh_view.h"
+#include "tests/testing.h"
+
+using namespace luisa::render;
+
+namespace {
+
+// two triangles sharing an edge
+[[nodiscard]] MeshBuffers make_quad() {
+    return {.P = {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 1.f, 0.f, 0.f, 1.f, 0.f},
+            .N = {0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 0.f, 0.f, 1.f},
+            .uv = {0.f, 0.f, 1.f, 0.f, 1.f, 1.f, 0.f, 1.f},
+            .indices = {0, 1, 2, 0, 2, 3}};
+}
+
+// the mesh with its vertex attributes interleaved, as in a PLY vertex record
+// of x y z nx ny nz u v and a padding byte, and its faces as PLY face records
+struct InterleavedMesh {
+    static constexpr auto vertex_stride = 8u * sizeof(float) + 1u;
+    static constexpr auto face_stride = 1u + 3u * sizeof(int);
+    std::vector<std::byte> vertices;
+    std::vector<std::byte> faces;
+    MeshView view;
+    explicit InterleavedMesh(const MeshBuffers &mesh) {
+        auto num_vertices = static_cast<uint32_t>(mesh.P.size() / 3u);
+        auto num_triangles = static_cast<uint32_t>(mesh.indices.size() / 3u);
+        vertices.resize(num_vertices * vertex_stride, std::byte{0xcd});
+        faces.resize(num_triangles * face_stride, std::byte{3});
+        for (auto v = 0u; v < num_vertices; v++) {
+            auto record = vertices.data() + v * vertex_stride;
+            std::memcpy(record, mesh.P.data() + v * 3u, sizeof(float) * 3u);
+            std::memcpy(record + sizeof(float) * 3u, mesh.N.data() + v * 3u, sizeof(float) * 3u);
+            std::memcpy(record + sizeof(float) * 6u, mesh.uv.data() + v * 2u, sizeof(float) * 2u);
+        }
+        for (auto t = 0u; t < num_triangles; t++) {
+            std::memcpy(faces.data() + t * face_stride + 1u, mesh.indices.data() + t * 3u, sizeof(int) * 3u);
+        }
+        view = {.num_vertices = num_vertices,
+                .num_triangles = num_triangles,
+                .P = {vertices.data(), vertex_stride},
+                .N = {vertices.data() + sizeof(float) * 3u, vertex_stride},
+                .uv = {vertices.data() + sizeof(float) * 6u, vertex_stride},
+                .indices = {faces.data() + 1u, face_stride}};
+    }
+};
+
+void test_layout_independence() {
+    auto quad = make_quad();
+    InterleavedMesh interleaved{quad};
+    luisa::expect(mesh_equal(quad.view(), interleaved.view), "Equal meshes in different layouts differ.");
+    luisa::expect(mesh_equal(interleaved.view, quad.view()), "mesh_equal() is not symmetric.");
+    luisa::expect(hash_mesh(quad.view()) == hash_mesh(interleaved.view), "Equal meshes hash differently.");
+    auto copy = copy_mesh(interleaved.view);
+    luisa::expect(copy.P == quad.P && copy.N == quad.N && copy.uv == quad.uv && copy.indices == quad.indices,
+                  "copy_mesh() changed the mesh.");
+}
+
+void test_differences() {
+    auto quad = make_quad();
+    auto expect_different = [&](const char *change, const MeshBuffers &other) {
+        luisa::expect(!mesh_equal(quad.view(), other.view()), "Meshes with {} compare equal.", change);
+        luisa::expect(!mesh_equal(other.view(), quad.view()), "Meshes with {} compare equal.", change);
+        luisa::expect(hash_mesh(quad.view()) != hash_mesh(other.view()), "Meshes with {} hash equally.", change);
+    };
+    auto other = quad;
+    other.P[7] = 1.5f;
+    expect_different("a position changed", other);
+    other = quad;
+    other.N[2] = -1.f;
+    expect_different("a normal changed", other);
+    other = quad;
+    other.uv[3] = .5f;
+    expect_different("a uv changed", other);
+    other = quad;
+    std::swap(other.indices[1], other.indices[2]);
+    expect_different("a triangle flipped", other);
+    other = quad;
+    other.N.clear();
+    expect_different("no normals", other);
+    other = quad;
+    other.uv.clear();
+    expect_different("no uvs", other);
+    other = quad;
+    other.indices.resize(3u);
+    expect_different("a triangle less", other);
+    // -0 and +0 are different bits, and so different meshes
+    other = quad;
+    other.P[0] = -0.f;
+    expect_different("a negative zero", other);
+}
+
+void test_large_meshes() {
+    // more than one chunk of the staging buffer, with a difference in the last one
+    MeshBuffers a;
+    constexpr auto n = 200'000u;
+    for (auto i = 0u; i < n; i++) {
+        auto x = static_cast<float>(i);
+        a.P.insert(a.P.end(), {x, -x, .5f * x});
+    }
+    for (auto i = 0u; i + 2u < n; i++) {
+        a.indices.insert(a.indices.end(), {static_cast<int>(i), static_cast<int>(i + 1u), static_cast<int>(i + 2u)});
+    }
+    auto b = a;
+    luisa::expect(mesh_equal(a.view(), b.view()) && hash_mesh(a.view()) == hash_mesh(b.view()),
+                  "Equal large meshes differ.");
+    b.P[b.P.size() - 1u] = 0.f;
+    luisa::expect(!mesh_equal(a.view(), b.view()), "Large meshes differing at the end compare equal.");
+    b = a;
+    b.indices[b.indices.size() - 1u] = 0;
+    luisa::expect(!mesh_equal(a.view(), b.view()), "Large meshes differing at the end compare equal.");
+}
+
+void test_find_identical_meshes() {
+    auto quad = make_quad();
+    auto flipped = quad;
+    std::swap(flipped.indices[1], flipped.indices[2]);
+    InterleavedMesh interleaved{quad};
+    std::vector<MeshView> meshes{quad.view(), flipped.view(), interleaved.view, flipped.view(), quad.view()};
+    auto included = [](uint32_t) { return true; };
+    auto equal = [&](uint32_t a, uint32_t b) { return mesh_equal(meshes[a], meshes[b]); };
+    std::vector<uint64_t> hashes;
+    for (auto &&m : meshes) { hashes.emplace_back(hash_mesh(m)); }
+    luisa::expect(find_identical_meshes(hashes, included, equal) == std::vector<uint32_t>{0u, 1u, 0u, 1u, 0u},
+                  "Identical meshes not found.");
+    // a hash shared by all meshes must not merge the different ones
+    std::vector<uint64_t> colliding(meshes.size(), 42u);
+    luisa::expect(find_identical_meshes(colliding, included, equal) == std::vector<uint32_t>{0u, 1u, 0u, 1u, 0u},
+                  "Colliding hashes merged different meshes.");
+    // different hashes are never compared, even for equal meshes
+    auto compared = false;
+    auto identical = find_identical_meshes({1u, 2u, 3u}, included, [&](uint32_t, uint32_t) {
+        compared = true;
+        return true;
+    });
+    luisa::expect(!compared && identical == std::vector<uint32_t>{0u, 1u, 2u}, "Meshes of different hashes merged.");
+    // the excluded meshes are neither merged nor merged into
+    auto first_excluded = find_identical_meshes(hashes, [](uint32_t i) { return i != 0u; }, equal);
+    luisa::expect(first_excluded == std::vector<uint32_t>{0u, 1u, 2u, 1u, 2u}, "An excluded mesh was merged.");
+}
+
+}// namespace
+
+int main() {
+    return luisa::test::run_tests({
+        {"layout independence", test_layout_independence},
+        {"differences", test_differences},
+        {"large meshes", test_large_meshes},
+        {"find identical meshes", test_find_identical_meshes},
+    });
+}
@@ -0,0 +1,216 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <bit>
+#include <array>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <string_view>
+
+#include "logging.h"
+#include "mesh_view.h"
+#include "mesh_writer.h"
+#include "mesh_splitter.h"
+#include "ply_mesh.h"
+#include "tests/testing.h"
+
+using namespace luisa::render;
+
+namespace {
+
+constexpr auto native_format = std::endian::native == std::endian::little ?
+                                   "binary_little_endian" :
+                                   "binary_big_endian";
+constexpr auto foreign_format = std::endian::native == std::endian::little ?
+                                    "binary_big_endian" :
+                                    "binary_little_endian";
+
+// the header of a single triangle with float positions
+[[nodiscard]] std::string triangle_header(std::string_view format = native_format) {
+    return luisa::format("ply\n"
+                         "format {} 1.0\n"
+                         "element vertex 3\n"
+                         "property float x\n"
+                         "property float y\n"
+                         "property float z\n"
+                         "element face 1\n"
+                         "property list uchar int vertex_indices\n"
+                         "end_header\n",
+                         format);
+}
+
+// the payload of a single triangle, with the face record given
+[[nodiscard]] std::string triangle_payload(uint8_t count = 3u, std::array<int, 3u> indices = {0, 1, 2}) {
+    constexpr float positions[]{0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+    std::string payload(sizeof(positions) + 1u + sizeof(indices), '\0');
+    std::memcpy(payload.data(), positions, sizeof(positions));
+    payload[sizeof(positions)] = static_cast<char>(count);
+    std::memcpy(payload.data() + sizeof(positions) + 1u, indices.data(), sizeof(indices));
+    return payload;
+}
+
+void write_file(const std::filesystem::path &path, std::string_view content) {
+    std::ofstream file{path, std::ios::binary};
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    luisa::expect(file.good(), "Failed to write {}.", path.generic_string());
+}
+
+void test_round_trip() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-ply-round-trip"};
+    auto mesh = luisa::test::make_grid(8u);
+    auto path = dir.path() / "grid.ply";
+    dump_mesh_to_binary_ply(path, mesh.view());
+    auto mapped = map_binary_ply_mesh(path);
+    luisa::expect(mapped != nullptr, "The written mesh is not mapped.");
+    luisa::expect(mesh_equal(mapped->view, mesh.view()), "The mapped mesh differs from the written one.");
+    luisa::expect(hash_mesh(mapped->view) == hash_mesh(mesh.view()), "The mapped mesh hashes differently.");
+    auto stream = PlyMeshStream::open(path);
+    luisa::expect(stream != nullptr, "The written mesh is not streamed.");
+    luisa::expect(stream->has_normals() && stream->has_uvs(), "The streamed mesh lost its attributes.");
+    auto view = stream->read_vertices(0u, stream->num_vertices());
+    auto faces = stream->read_triangles(0u, stream->num_triangles());
+    view.num_triangles = faces.num_triangles;
+    view.indices = faces.indices;
+    luisa::expect(mesh_equal(view, mesh.view()), "The streamed mesh differs from the written one.");
+}
+
+void test_malformed_headers() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-ply-headers"};
+    auto valid = triangle_header();
+    auto replace = [&valid](std::string_view from, std::string_view to) {
+        auto header = valid;
+        auto offset = header.find(from);
+        luisa::expect(offset != std::string::npos, "No '{}' in the header.", from);
+        return header.replace(offset, from.size(), to);
+    };
+    std::pair<std::string_view, std::string> headers[]{
+        {"wrong magic", replace("ply\n", "plx\n")},
+        {"ascii", replace(native_format, "ascii")},
+        {"foreign byte order", triangle_header(foreign_format)},
+        {"no format", replace(luisa::format("format {} 1.0\n", native_format), "")},
+        {"truncated before end_header", valid.substr(0u, valid.find("end_header"))},
+        {"truncated mid-line", valid.substr(0u, valid.find("property float y") + 10u)},
+        {"bad element count", replace("element vertex 3", "element vertex three")},
+        {"negative element count", replace("element vertex 3", "element vertex -3")},
+        {"element count overflow", replace("element vertex 3", "element vertex 99999999999999999999")},
+        {"vertex count above 32 bits", replace("element vertex 3", "element vertex 4294967296")},
+        {"element without count", replace("element vertex 3", "element vertex")},
+        {"property before element", replace("element vertex 3\n", "property float w\nelement vertex 3\n")},
+        {"unknown property type", replace("property float x", "property half x")},
+        {"integer position", replace("property float x", "property int x")},
+        {"property without name", replace("property float z", "property float")},
+        {"list in vertex", replace("property float z", "property list uchar float z")},
+        {"unknown keyword", replace("end_header", "bogus\nend_header")},
+        {"faces before vertices", replace("element vertex 3", "element face 0\nelement vertex 3")},
+        {"16-bit indices", replace("list uchar int", "list uchar short")},
+        {"32-bit face counts", replace("list uchar int", "list int int")},
+        {"no face indices", replace("vertex_indices", "vertex_colors")},
+    };
+    for (auto &&[name, header] : headers) {
+        auto path = dir.path() / "mesh.ply";
+        write_file(path, header + triangle_payload());
+        luisa::expect(map_binary_ply_mesh(path) == nullptr, "Mapped the mesh with a header of {}.", name);
+        luisa::expect(PlyMeshStream::open(path) == nullptr, "Streamed the mesh with a header of {}.", name);
+    }
+    // the unchanged header is accepted, CRLF line ends and comments included
+    auto path = dir.path() / "mesh.ply";
+    for (auto &&header : {valid, replace("element vertex 3\n", "comment a\r\nelement vertex 3\r\n")}) {
+        write_file(path, header + triangle_payload());
+        luisa::expect(map_binary_ply_mesh(path) != nullptr, "Failed to map a valid mesh.");
+        luisa::expect(PlyMeshStream::open(path) != nullptr, "Failed to stream a valid mesh.");
+    }
+}
+
+void test_truncated_payload() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-ply-payload"};
+    auto path = dir.path() / "mesh.ply";
+    auto file = triangle_header() + triangle_payload();
+    for (auto missing : {1u, 12u, 13u}) {
+        write_file(path, std::string_view{file}.substr(0u, file.size() - missing));
+        luisa::expect(map_binary_ply_mesh(path) == nullptr, "Mapped a mesh missing {} bytes.", missing);
+        luisa::expect(PlyMeshStream::open(path) == nullptr, "Streamed a mesh missing {} bytes.", missing);
+    }
+    luisa::expect(map_binary_ply_mesh(dir.path() / "missing.ply") == nullptr, "Mapped a missing file.");
+    luisa::expect(PlyMeshStream::open(dir.path() / "missing.ply") == nullptr, "Streamed a missing file.");
+}
+
+void test_invalid_faces() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-ply-faces"};
+    auto path = dir.path() / "mesh.ply";
+    std::pair<std::string_view, std::string> payloads[]{
+        {"a quad", triangle_payload(4u)},
+        {"an out-of-range index", triangle_payload(3u, {0, 1, 3})},
+        {"a negative index", triangle_payload(3u, {0, -1, 2})},
+    };
+    for (auto &&[name, payload] : payloads) {
+        write_file(path, triangle_header() + payload);
+        luisa::expect(map_binary_ply_mesh(path) == nullptr, "Mapped a mesh with {}.", name);
+        // the stream checks the faces as they are read
+        auto stream = PlyMeshStream::open(path);
+        luisa::expect(stream != nullptr, "Failed to open the mesh with {}.", name);
+        auto thrown = false;
+        try {
+            static_cast<void>(stream->read_triangles(0u, 1u));
+        } catch (const luisa::Error &) {
+            thrown = true;
+        }
+        luisa::expect(thrown, "Read a mesh with {}.", name);
+    }
+}
+
+void test_split() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-ply-split"};
+    auto mesh = luisa::test::make_grid(64u);
+    auto path = dir.path() / "grid.ply";
+    dump_mesh_to_binary_ply(path, mesh.view());
+    auto stream = PlyMeshStream::open(path);
+    luisa::expect(stream != nullptr, "Failed to open the mesh.");
+    auto plan = plan_mesh_split(*stream, 1000u);
+    luisa::expect(plan.part_count > 1u, "The mesh was not split.");
+    // the triangles of the parts, as positions, must be those of the mesh
+    using Triangle = std::array<float, 9u>;
+    auto triangles_of = [](const MeshView &m) {
+        std::vector<Triangle> triangles(m.num_triangles);
+        for (auto t = 0u; t < m.num_triangles; t++) {
+            int indices[3];
+            std::memcpy(indices, m.indices.at(t), sizeof(indices));
+            for (auto i = 0u; i < 3u; i++) {
+                luisa::expect(indices[i] >= 0 && static_cast<uint32_t>(indices[i]) < m.num_vertices,
+                              "Index out of range in a part.");
+                std::memcpy(triangles[t].data() + i * 3u, m.P.at(indices[i]), sizeof(float) * 3u);
+            }
+        }
+        return triangles;
+    };
+    std::vector<Triangle> split_triangles;
+    auto parts_written = 0u;
+    split_mesh(*stream, plan, dir.path() / "grid.ply.split", [&](uint32_t part, const MeshView &m) {
+        luisa::expect(part == parts_written++, "Parts written out of order.");
+        luisa::expect(m.num_triangles == plan.part_triangles[part], "Unexpected triangle count in part {}.", part);
+        luisa::expect(m.N && m.uv, "Part {} lost its attributes.", part);
+        auto t = triangles_of(m);
+        split_triangles.insert(split_triangles.end(), t.cbegin(), t.cend());
+    });
+    luisa::expect(parts_written == plan.part_count, "Wrote {} of {} parts.", parts_written, plan.part_count);
+    luisa::expect(!std::filesystem::exists(dir.path() / "grid.ply.split"), "The temporary file was kept.");
+    auto triangles = triangles_of(mesh.view());
+    std::ranges::sort(triangles);
+    std::ranges::sort(split_triangles);
+    luisa::expect(triangles == split_triangles, "The parts do not cover the mesh.");
+}
+
+}// namespace
+
+int main() {
+    return luisa::test::run_tests({
+        {"round trip", test_round_trip},
+        {"malformed headers", test_malformed_headers},
+        {"truncated payload", test_truncated_payload},
+        {"invalid faces", test_invalid_faces},
+        {"split", test_split},
+    });
+}
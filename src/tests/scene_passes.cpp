@@ -0,0 +1,191 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <string>
+#include <string_view>
+
+#include <nlohmann/json.hpp>
+
+#include "logging.h"
+#include "scene_graph.h"
+#include "scene_passes.h"
+#include "tests/testing.h"
+
+using namespace luisa::render;
+using nlohmann::json;
+
+namespace {
+
+[[nodiscard]] json constant(json v) {
+    return {{"type", "Texture"}, {"impl", "Constant"}, {"prop", {{"v", std::move(v)}}}};
+}
+
+[[nodiscard]] json texture(std::string_view impl, json prop) {
+    return {{"type", "Texture"}, {"impl", impl}, {"prop", std::move(prop)}};
+}
+
+[[nodiscard]] json surface(std::string_view impl, json prop) {
+    return {{"type", "Surface"}, {"impl", impl}, {"prop", std::move(prop)}};
+}
+
+[[nodiscard]] NodeHandle handle(const SceneGraph &graph, std::string_view name) {
+    auto node = graph.find(name);
+    luisa::expect(node.has_value(), "No node {}.", name);
+    return *node;
+}
+
+// the value of the Constant texture a node was folded into
+[[nodiscard]] json folded(const json &node) {
+    luisa::expect(node.value("impl", "") == "Constant", "Not folded: {}.", node.dump());
+    return node.at("prop").at("v");
+}
+
+void test_fold() {
+    SceneGraph graph;
+    static_cast<void>(graph.add("half", constant({.5, .5, .5})));
+    static_cast<void>(graph.add("two", constant(2)));
+    static_cast<void>(graph.add("image", texture("Image", {{"file", "a.png"}})));
+    // by reference and inline
+    auto multiply = graph.add("multiply", texture("Multiply", {{"a", "@half"}, {"b", constant({2, 4, 6})}}));
+    auto scale = graph.add("scale", texture("Scale", {{"base", "@half"}, {"scale", 4}}));
+    auto scale3 = graph.add("scale3", texture("Scale", {{"base", "@half"}, {"scale", {1, 2, 3}}}));
+    auto concat = graph.add("concat", texture("Concat", {{"channels", json::array({"@two", constant({3, 4})})}}));
+    // folding sees through folded references and nested textures
+    auto nested = graph.add("nested", texture("Multiply", {{"a", "@scale"}, {"b", texture("Scale", {{"base", "@half"}, {"scale", 2}})}}));
+    auto matte = graph.add("matte", surface("Matte", {{"Kd", texture("Multiply", {{"a", constant({.5})}, {"b", constant({.5})}})}}));
+    // not constant or not well-formed: left alone
+    std::string_view unfolded[]{"with_image", "mismatched", "dangling", "extra_prop", "too_wide"};
+    static_cast<void>(graph.add("with_image", texture("Multiply", {{"a", "@image"}, {"b", "@half"}})));
+    static_cast<void>(graph.add("mismatched", texture("Multiply", {{"a", "@half"}, {"b", constant({1, 2})}})));
+    static_cast<void>(graph.add("dangling", texture("Scale", {{"base", "@missing"}, {"scale", 2}})));
+    static_cast<void>(graph.add("extra_prop", texture("Scale", {{"base", "@half"}, {"scale", 2}, {"encoding", "sRGB"}})));
+    static_cast<void>(graph.add("too_wide", texture("Concat", {{"channels", {"@half", "@two", "@two"}}})));
+    auto originals = json::array();
+    for (auto name : unfolded) { originals.emplace_back(graph.node(handle(graph, name))); }
+
+    auto count = fold_constant_textures(graph);
+    luisa::expect(count == 6u, "Folded {} textures instead of 6.", count);
+    luisa::expect(folded(graph.node(multiply)) == json{1, 2, 3}, "Wrong Multiply: {}.", graph.node(multiply).dump());
+    luisa::expect(folded(graph.node(scale)) == json{2, 2, 2}, "Wrong Scale: {}.", graph.node(scale).dump());
+    luisa::expect(folded(graph.node(scale3)) == json{.5, 1, 1.5}, "Wrong Scale: {}.", graph.node(scale3).dump());
+    luisa::expect(folded(graph.node(concat)) == json{2, 3, 4}, "Wrong Concat: {}.", graph.node(concat).dump());
+    luisa::expect(folded(graph.node(nested)) == json{2, 2, 2}, "Wrong nested fold: {}.", graph.node(nested).dump());
+    luisa::expect(folded(graph.node(matte).at("prop").at("Kd")) == json{.25}, "Wrong inline fold: {}.", graph.node(matte).dump());
+    // the node keeps its type, so it stays a Texture node
+    luisa::expect(graph.node(multiply).at("type") == "Texture", "The folded node lost its type.");
+    for (auto i = 0u; i < std::size(unfolded); i++) {
+        luisa::expect(graph.node(handle(graph, unfolded[i])) == originals[i], "Folded {}.", unfolded[i]);
+    }
+    luisa::expect(fold_constant_textures(graph) == 0u, "Folding is not idempotent.");
+}
+
+void test_merge() {
+    SceneGraph graph;
+    auto red = graph.add("red", constant({1, 0, 0}));
+    auto red_copy = graph.add("red_copy", constant({1, 0, 0}));
+    auto green = graph.add("green", constant({0, 1, 0}));
+    auto a = graph.add("a", surface("Matte", {{"Kd", "@red"}}));
+    // identical to "a" only once the textures are merged
+    auto b = graph.add("b", surface("Matte", {{"Kd", "@red_copy"}}));
+    auto c = graph.add("c", surface("Matte", {{"Kd", "@green"}}));
+    // identical only once the surfaces are merged, in a later round
+    auto mix = graph.add("mix", surface("Mix", {{"a", "@a"}, {"b", "@c"}, {"ratio", .5}}));
+    auto mix_copy = graph.add("mix_copy", surface("Mix", {{"a", "@b"}, {"b", "@c"}, {"ratio", .5}}));
+    // different content of the same shape
+    auto mix_other = graph.add("mix_other", surface("Mix", {{"a", "@b"}, {"b", "@c"}, {"ratio", .25}}));
+    // nodes of other kinds are rewritten, but never merged
+    auto light = graph.add("light", {{"type", "Light"}, {"impl", "Diffuse"}, {"prop", {{"emission", "@red_copy"}}}});
+    auto render = graph.add("render", {{"type", "Render"}, {"surfaces", {"@mix_copy", "@b", "@mix_other"}}});
+    auto render_copy = graph.add("render_copy", graph.node(render));
+
+    auto count = merge_identical_nodes(graph);
+    luisa::expect(count == 3u, "Merged {} nodes instead of 3.", count);
+    for (auto [node, by] : {std::pair{red_copy, red}, std::pair{b, a}, std::pair{mix_copy, mix}}) {
+        luisa::expect(graph.removed(node) && graph.resolve(node) == by,
+                      "{} not merged into {}.", graph.name(node), graph.name(by));
+    }
+    for (auto node : {red, green, a, c, mix, mix_other, light, render, render_copy}) {
+        luisa::expect(!graph.removed(node) && graph.resolve(node) == node, "{} was merged.", graph.name(node));
+    }
+    luisa::expect(graph.node(light).at("prop").at("emission") == "@red", "The light reference was not rewritten.");
+    luisa::expect(graph.node(render).at("surfaces") == json{"@mix", "@a", "@mix_other"},
+                  "The render references were not rewritten: {}.", graph.node(render).dump());
+    luisa::expect(graph.node(mix_other).at("prop").at("a") == "@a", "The references of kept nodes were not rewritten.");
+    luisa::expect(merge_identical_nodes(graph) == 0u, "Merging is not idempotent.");
+}
+
+void test_fold_then_merge() {
+    SceneGraph graph;
+    static_cast<void>(graph.add("half", constant({.5, .5, .5})));
+    // folded values are floating-point, and nodes are merged only if written alike, 1.0 and not 1
+    auto white = graph.add("white", constant({1., 1., 1.}));
+    auto doubled = graph.add("doubled", texture("Scale", {{"base", "@half"}, {"scale", 2}}));
+    auto a = graph.add("a", surface("Matte", {{"Kd", "@white"}}));
+    auto b = graph.add("b", surface("Matte", {{"Kd", "@doubled"}}));
+    // surfaces of inline textures that fold to the same constant
+    auto c = graph.add("c", surface("Matte", {{"Kd", texture("Scale", {{"base", constant({.25})}, {"scale", 2}})}}));
+    auto d = graph.add("d", surface("Matte", {{"Kd", texture("Multiply", {{"a", constant({.5})}, {"b", constant({1})}})}}));
+    luisa::expect(fold_constant_textures(graph) == 3u, "Expected 3 textures folded.");
+    luisa::expect(merge_identical_nodes(graph) == 3u, "Expected 3 nodes merged.");
+    luisa::expect(graph.resolve(doubled) == white && graph.resolve(b) == a && graph.resolve(d) == c,
+                  "Folded nodes were not merged.");
+    luisa::expect(!graph.removed(white) && !graph.removed(a) && !graph.removed(c), "Kept nodes were removed.");
+}
+
+void test_prune() {
+    SceneGraph graph;
+    auto camera = graph.add("camera", {{"type", "Camera"}, {"impl", "Pinhole"}});
+    auto render = graph.add("render", {{"type", "Render"}, {"cameras", json::array({"@camera"})}, {"environment", "@sky"}});
+    auto sky = graph.add("sky", {{"type", "Environment"}, {"impl", "Map"}, {"prop", {{"emission", "@sky_map"}}}});
+    auto sky_map = graph.add("sky_map", texture("Image", {{"file", "sky.exr"}}));
+    auto used = graph.add("used", surface("Mix", {{"a", "@used_a"}, {"b", "@used_b"}}));
+    auto used_a = graph.add("used_a", surface("Matte", {{"Kd", "@shared"}}));
+    // reachable cycles do not loop
+    auto used_b = graph.add("used_b", surface("Mix", {{"a", "@used"}, {"b", "@used_a"}}));
+    auto shared = graph.add("shared", constant({1, 1, 1}));
+    auto unused = graph.add("unused", surface("Matte", {{"Kd", "@shared"}, {"Ks", "@unused_only"}}));
+    auto unused_only = graph.add("unused_only", constant({0, 0, 0}));
+    auto cycle_a = graph.add("cycle_a", surface("Mix", {{"a", "@cycle_b"}}));
+    auto cycle_b = graph.add("cycle_b", surface("Mix", {{"a", "@cycle_a"}}));
+    auto lonely = graph.add("lonely", {{"type", "Light"}, {"impl", "Diffuse"}});
+    // the shapes, which are not in the graph, refer to their surfaces, and to unknown names
+    auto roots = json{{"renderable", json::array({"@used", "@missing"})}, {"render", "@render"}};
+
+    auto count = remove_unreachable_nodes(graph, roots);
+    luisa::expect(count == 5u, "Removed {} nodes instead of 5.", count);
+    for (auto node : {camera, render, sky, sky_map, used, used_a, used_b, shared}) {
+        luisa::expect(!graph.removed(node), "Removed the reachable {}.", graph.name(node));
+    }
+    for (auto node : {unused, unused_only, cycle_a, cycle_b, lonely}) {
+        luisa::expect(graph.removed(node), "Kept the unreachable {}.", graph.name(node));
+    }
+    luisa::expect(remove_unreachable_nodes(graph, roots) == 0u, "Pruning is not idempotent.");
+}
+
+void test_merge_then_prune() {
+    // references to merged nodes are rewritten, so the replaced nodes are not reached again
+    SceneGraph graph;
+    auto red = graph.add("red", constant({1, 0, 0}));
+    auto red_copy = graph.add("red_copy", constant({1, 0, 0}));
+    auto a = graph.add("a", surface("Matte", {{"Kd", "@red"}}));
+    auto b = graph.add("b", surface("Matte", {{"Kd", "@red_copy"}}));
+    luisa::expect(merge_identical_nodes(graph) == 2u, "Expected 2 nodes merged.");
+    // the shapes name their surfaces after the merge through resolve()
+    auto roots = json::array({"@" + graph.name(graph.resolve(b))});
+    luisa::expect(remove_unreachable_nodes(graph, roots) == 0u, "Pruned a node after merging.");
+    luisa::expect(!graph.removed(red) && !graph.removed(a), "Removed a kept node.");
+    luisa::expect(graph.removed(red_copy) && graph.removed(b), "Kept a merged node.");
+}
+
+}// namespace
+
+int main() {
+    return luisa::test::run_tests({
+        {"fold", test_fold},
+        {"merge", test_merge},
+        {"fold then merge", test_fold_then_merge},
+        {"prune", test_prune},
+        {"merge then prune", test_merge_then_prune},
+    });
+}
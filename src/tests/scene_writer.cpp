@@ -0,0 +1,173 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+#include <nlohmann/json.hpp>
+
+#include "logging.h"
+#include "cache.h"
+#include "async_file_writer.h"
+#include "scene_writer.h"
+#include "transform_table.h"
+#include "tests/testing.h"
+
+using namespace luisa::render;
+using nlohmann::json;
+
+namespace {
+
+[[nodiscard]] std::string read_file(const std::filesystem::path &path) {
+    std::ifstream file{path, std::ios::binary};
+    luisa::expect(file.is_open(), "Failed to open {}.", path.generic_string());
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+[[nodiscard]] json parse_scene(const std::filesystem::path &path, SceneFormat format) {
+    auto content = read_file(path);
+    switch (format) {
+        case SceneFormat::JSON:
+        case SceneFormat::CompactJSON: return json::parse(content);
+        case SceneFormat::CBOR: return json::from_cbor(content);
+        case SceneFormat::MessagePack: return json::from_msgpack(content);
+        case SceneFormat::UBJSON: return json::from_ubjson(content);
+    }
+    luisa::panic("Invalid scene format.");
+}
+
+// writes the nodes of `scene` one by one and reads the file back
+[[nodiscard]] json write_and_parse(const std::filesystem::path &dir, const json &scene, SceneFormat format) {
+    ConversionCache cache{dir, "scene", false};
+    auto file_name = luisa::format("scene.{}", scene_format_extension(format));
+    {
+        SceneWriter writer{dir, file_name, format};
+        for (auto &&[name, node] : scene.items()) { writer.write(name, node); }
+        luisa::expect(writer.node_count() == scene.size(), "Counted {} of {} nodes.", writer.node_count(), scene.size());
+        writer.finish(cache);
+    }
+    return parse_scene(dir / file_name, format);
+}
+
+constexpr std::array formats{SceneFormat::JSON, SceneFormat::CompactJSON, SceneFormat::CBOR,
+                             SceneFormat::MessagePack, SceneFormat::UBJSON};
+
+void test_formats() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-scene-writer-formats"};
+    auto scene = json::parse(R"({
+        "Camera": {"type": "Camera", "impl": "Pinhole", "prop": {"fov": 45.5, "position": [0, 4, -6]}},
+        "Shape:0": {"type": "Shape", "impl": "Mesh", "prop": {"file": "lr_exported_meshes/scene.00000.ply", "surface": "@Mat"}},
+        "Mat": {"type": "Surface", "impl": "Matte", "prop": {"Kd": {"impl": "Constant", "prop": {"v": [0.5, 0.25, -1e-30]}}}},
+        "Unicode: é中": {"type": "Texture", "impl": "Image", "prop": {"file": "t\"e\\x\nt.png", "empty": {}, "list": []}},
+        "Numbers": {"big": 18446744073709551615, "negative": -9223372036854775808, "flag": true, "nothing": null}
+    })");
+    for (auto format : formats) {
+        auto name = scene_format_extension(format);
+        luisa::expect(write_and_parse(dir.path(), scene, format) == scene, "The {} scene differs.", name);
+        luisa::expect(write_and_parse(dir.path(), json::object(), format) == json::object(),
+                      "The empty {} scene is not an empty object.", name);
+    }
+    // the pretty-printed JSON matches a dump of the whole object
+    static_cast<void>(write_and_parse(dir.path(), scene, SceneFormat::JSON));
+    luisa::expect(read_file(dir.path() / "scene.json") == scene.dump(4), "The JSON layout differs from dump(4).");
+}
+
+void test_large_scenes() {
+    // several flushes of the 4 MB buffer through the background writer
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-scene-writer-large"};
+    auto scene = json::object();
+    for (auto i = 0u; i < 100'000u; i++) {
+        scene[luisa::format("Shape:{}", i)] = {{"type", "Shape"},
+                                               {"impl", "Mesh"},
+                                               {"prop", {{"file", luisa::format("lr_exported_meshes/scene.{:05}.obj", i)}, {"index", i}}}};
+    }
+    for (auto format : formats) {
+        luisa::expect(write_and_parse(dir.path(), scene, format) == scene,
+                      "The large {} scene differs.", scene_format_extension(format));
+    }
+}
+
+void test_unfinished_writer() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-scene-writer-unfinished"};
+    {
+        std::ofstream{dir.path() / "scene.json"} << "{\"old\": {}}";
+        SceneWriter writer{dir.path(), "scene.json", SceneFormat::JSON};
+        writer.write("new", json::object());
+        // destroyed without finish(), e.g. on an error: the old file stays, the temporary goes
+    }
+    luisa::expect(read_file(dir.path() / "scene.json") == "{\"old\": {}}", "The unfinished writer replaced the file.");
+    luisa::expect(!std::filesystem::exists(dir.path() / "scene.json.tmp"), "The temporary file was kept.");
+}
+
+void test_async_file_writer() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-async-file-writer"};
+    auto path = dir.path() / "out.bin";
+    std::string expected;
+    {
+        luisa::AsyncFileWriter writer{path, 2u};
+        luisa::expect(writer.is_open(), "Failed to open {}.", path.generic_string());
+        luisa::AsyncFileWriter::Buffer buffer;
+        for (auto i = 0u; i < 64u; i++) {
+            // buffers of varying sizes, submitted and written directly
+            buffer.assign(1000u + i * 997u, static_cast<char>('a' + i % 26u));
+            expected += buffer;
+            buffer = writer.submit(std::move(buffer));
+            luisa::expect(buffer.empty(), "submit() returned a non-empty buffer.");
+            auto line = luisa::format("line {}\n", i);
+            writer.write(line.data(), line.size());
+            expected += line;
+        }
+        // patch the start, as the MessagePack scene writer does with the node count
+        writer.overwrite(1u, "XYZ", 3u);
+        expected.replace(1u, 3u, "XYZ");
+        luisa::expect(writer.close(), "Failed to write {}.", path.generic_string());
+        luisa::expect(!writer.is_open(), "The closed writer is open.");
+    }
+    luisa::expect(read_file(path) == expected, "The written file differs.");
+    luisa::AsyncFileWriter missing{dir.path() / "missing" / "out.bin"};
+    luisa::expect(!missing.is_open(), "Opened a file in a missing directory.");
+}
+
+void test_transform_table() {
+    luisa::test::TempDirectory dir{"pbrt2luisa-test-transform-table"};
+    TransformTable table;
+    float identity[4][4]{{1.f, 0.f, 0.f, 0.f}, {0.f, 1.f, 0.f, 0.f}, {0.f, 0.f, 1.f, 0.f}, {0.f, 0.f, 0.f, 1.f}};
+    float translate[4][4]{{1.f, 0.f, 0.f, 2.f}, {0.f, 1.f, 0.f, 3.f}, {0.f, 0.f, 1.f, 4.f}, {0.f, 0.f, 0.f, 1.f}};
+    float projective[4][4]{{1.f, 0.f, 0.f, 0.f}, {0.f, 1.f, 0.f, 0.f}, {0.f, 0.f, 1.f, 0.f}, {0.f, 0.f, 1.f, 0.f}};
+    luisa::expect(table.add(identity) == 0u, "The first transform is not at index 0.");
+    luisa::expect(table.add(translate) == 1u, "The second transform is not at index 1.");
+    luisa::expect(table.add(identity) == 0u, "The identical transform was not shared.");
+    luisa::expect(!table.add(projective), "A projective transform was stored.");
+    luisa::expect(table.size() == 2u, "The table has {} entries.", table.size());
+    auto size = table.size();
+    auto path = dir.path() / "transforms.bin";
+    table.write(path);
+    auto content = read_file(path);
+    luisa::expect(content.size() == 8u + 8u + size * 48u, "The table has {} bytes.", content.size());
+    luisa::expect(content.compare(0u, 8u, std::string_view{"LRXFORM\0", 8u}) == 0, "Wrong magic.");
+    uint32_t header[2];
+    std::memcpy(header, content.data() + 8u, sizeof(header));
+    luisa::expect(header[0] == 1u && header[1] == size, "Wrong header {} {}.", header[0], header[1]);
+    TransformTable::Entry entry;
+    std::memcpy(entry.data(), content.data() + 16u + 48u, sizeof(entry));
+    luisa::expect(entry == TransformTable::Entry{1.f, 0.f, 0.f, 2.f, 0.f, 1.f, 0.f, 3.f, 0.f, 0.f, 1.f, 4.f},
+                  "The second entry differs.");
+}
+
+}// namespace
+
+int main() {
+    return luisa::test::run_tests({
+        {"formats", test_formats},
+        {"large scenes", test_large_scenes},
+        {"unfinished writer", test_unfinished_writer},
+        {"async file writer", test_async_file_writer},
+        {"transform table", test_transform_table},
+    });
+}
@@ -0,0 +1,85 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <string_view>
+#include <filesystem>
+#include <initializer_list>
+
+#include "logging.h"
+#include "mesh_view.h"
+
+namespace luisa::test {
+
+struct TestCase {
+    std::string_view name;
+    std::function<void()> run;
+};
+
+// Runs the tests, which fail by throwing, e.g. from luisa::expect(), and
+// returns the exit code for ctest.
+[[nodiscard]] inline int run_tests(std::initializer_list<TestCase> tests) noexcept {
+    auto failed = 0u;
+    for (auto &&test : tests) {
+        try {
+            test.run();
+            luisa::println("[passed] {}", test.name);
+        } catch (const std::exception &e) {
+            luisa::eprintln("[failed] {}: {}", test.name, e.what());
+            failed++;
+        }
+    }
+    luisa::println("{} of {} tests passed.", tests.size() - failed, tests.size());
+    return failed == 0u ? 0 : 1;
+}
+
+// An empty directory for the files written by a test, removed with it.
+class TempDirectory {
+
+private:
+    std::filesystem::path _path;
+
+public:
+    explicit TempDirectory(std::string_view name)
+        : _path{std::filesystem::temp_directory_path() / name} {
+        std::filesystem::remove_all(_path);
+        std::filesystem::create_directories(_path);
+    }
+    ~TempDirectory() noexcept {
+        std::error_code ec;
+        std::filesystem::remove_all(_path, ec);
+    }
+    TempDirectory(const TempDirectory &) = delete;
+    TempDirectory &operator=(const TempDirectory &) = delete;
+    [[nodiscard]] auto &path() const noexcept { return _path; }
+};
+
+// an n x n grid of quads, two triangles each, with normals and uvs
+[[nodiscard]] inline luisa::render::MeshBuffers make_grid(uint32_t n) {
+    luisa::render::MeshBuffers mesh;
+    for (auto y = 0u; y <= n; y++) {
+        for (auto x = 0u; x <= n; x++) {
+            auto u = static_cast<float>(x) / static_cast<float>(n);
+            auto v = static_cast<float>(y) / static_cast<float>(n);
+            mesh.P.insert(mesh.P.end(), {u, u * v, v});
+            mesh.N.insert(mesh.N.end(), {0.f, 1.f, 0.f});
+            mesh.uv.insert(mesh.uv.end(), {u, v});
+        }
+    }
+    for (auto y = 0u; y < n; y++) {
+        for (auto x = 0u; x < n; x++) {
+            auto v0 = static_cast<int>(y * (n + 1u) + x);
+            auto v1 = v0 + 1;
+            auto v2 = v0 + static_cast<int>(n + 1u);
+            auto v3 = v2 + 1;
+            mesh.indices.insert(mesh.indices.end(), {v0, v1, v3, v0, v3, v2});
+        }
+    }
+    return mesh;
+}
+
+}// namespace luisa::test
@@ -0,0 +1,171 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <condition_variable>
+
+#include "logging.h"
+#include "thread_pool.h"
+#include "tests/testing.h"
+
+using luisa::TaskGroup;
+using luisa::ThreadPool;
+
+namespace {
+
+// raises `max` to `value` if it is larger
+void update_max(std::atomic<int> &max, int value) noexcept {
+    for (auto m = max.load(); value > m && !max.compare_exchange_weak(m, value);) {}
+}
+
+void test_wait_runs_all_tasks() {
+    ThreadPool pool{4u};
+    std::atomic<int> count{0};
+    TaskGroup group{pool};
+    for (auto i = 0; i < 1000; i++) {
+        group.dispatch([&count] { count++; });
+    }
+    group.wait();
+    luisa::expect(count == 1000, "Ran {} of 1000 tasks.", count.load());
+    // the group can be reused after waiting
+    group.dispatch([&count] { count++; });
+    group.wait();
+    luisa::expect(count == 1001, "The reused group did not run its task.");
+}
+
+void test_wait_ignores_other_groups() {
+    ThreadPool pool{2u};
+    // a task of another group blocked until released must not hold up this group
+    std::mutex mutex;
+    std::condition_variable cv;
+    auto released = false;
+    TaskGroup blocked{pool};
+    blocked.dispatch([&] {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [&] { return released; });
+    });
+    std::atomic<int> count{0};
+    TaskGroup group{pool};
+    for (auto i = 0; i < 100; i++) {
+        group.dispatch([&count] { count++; });
+    }
+    group.wait();
+    luisa::expect(count == 100, "Ran {} of 100 tasks.", count.load());
+    {
+        std::scoped_lock lock{mutex};
+        released = true;
+    }
+    cv.notify_all();
+    blocked.wait();
+}
+
+void test_errors() {
+    ThreadPool pool{4u};
+    std::atomic<int> count{0};
+    TaskGroup group{pool};
+    for (auto i = 0; i < 100; i++) {
+        group.dispatch([&count, i] {
+            if (i % 10 == 3) { luisa::panic("Task {} failed.", i); }
+            count++;
+        });
+    }
+    auto thrown = false;
+    try {
+        group.wait();
+    } catch (const luisa::Error &) {
+        thrown = true;
+    }
+    // the error is reported once all tasks are done, and only once
+    luisa::expect(thrown, "The task error was not rethrown.");
+    luisa::expect(count == 90, "Ran {} of the 90 tasks that succeed.", count.load());
+    group.wait();
+}
+
+void test_destructor_waits() {
+    ThreadPool pool{2u};
+    std::atomic<int> count{0};
+    {
+        TaskGroup group{pool};
+        for (auto i = 0; i < 100; i++) {
+            group.dispatch([&count] {
+                std::this_thread::sleep_for(std::chrono::microseconds{100});
+                count++;
+            });
+        }
+    }
+    luisa::expect(count == 100, "The group was destroyed with {} of 100 tasks done.", count.load());
+}
+
+void test_nested_groups() {
+    // Scenes waiting for their own tasks from workers, as in batch mode. A waiting scene
+    // may only run its own tasks, never start another scene nested on its stack.
+    constexpr auto workers = 4;
+    ThreadPool pool{workers};
+    std::atomic<int> in_flight{0};
+    std::atomic<int> max_in_flight{0};
+    std::atomic<int> max_depth{0};
+    std::atomic<int> tasks_run{0};
+    static thread_local auto depth = 0;
+    TaskGroup scenes{pool};
+    for (auto s = 0; s < 32; s++) {
+        scenes.dispatch([&] {
+            update_max(max_depth, ++depth);
+            update_max(max_in_flight, ++in_flight);
+            TaskGroup meshes{pool};
+            for (auto i = 0; i < 20; i++) {
+                meshes.dispatch([&] {
+                    std::this_thread::sleep_for(std::chrono::microseconds{200});
+                    tasks_run++;
+                });
+            }
+            meshes.wait();
+            in_flight--;
+            depth--;
+        });
+    }
+    scenes.wait();
+    luisa::expect(tasks_run == 32 * 20, "Ran {} of {} tasks.", tasks_run.load(), 32 * 20);
+    luisa::expect(max_depth == 1, "Scenes were nested {} deep.", max_depth.load());
+    // one per worker, and one on the waiting thread
+    luisa::expect(max_in_flight <= workers + 1, "{} scenes were in flight on {} workers.", max_in_flight.load(), workers);
+}
+
+void test_synchronize() {
+    ThreadPool pool{2u};
+    std::atomic<int> count{0};
+    for (auto i = 0; i < 100; i++) {
+        pool.dispatch([&count] { count++; });
+    }
+    pool.synchronize();
+    luisa::expect(count == 100, "Ran {} of 100 tasks.", count.load());
+    // from a worker, it would wait for itself, and throws instead
+    std::atomic<bool> thrown{false};
+    pool.dispatch([&pool, &thrown] {
+        try {
+            pool.synchronize();
+        } catch (const luisa::Error &) {
+            thrown = true;
+        }
+    });
+    pool.synchronize();
+    luisa::expect(thrown, "synchronize() from a worker did not throw.");
+}
+
+}// namespace
+
+int main() {
+    return luisa::test::run_tests({
+        {"wait runs all tasks", test_wait_runs_all_tasks},
+        {"wait ignores other groups", test_wait_ignores_other_groups},
+        {"errors", test_errors},
+        {"destructor waits", test_destructor_waits},
+        {"nested groups", test_nested_groups},
+        {"synchronize", test_synchronize},
+    });
+}
@@ -0,0 +1,118 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <chrono>
+
+#include "hash.h"
+#include "cache.h"
+#include "logging.h"
+#include "profiler.h"
+#include "file_copy.h"
+#include "texture_stager.h"
+
+namespace luisa::render {
+
+TextureStager::TextureStager(const std::filesystem::path &base_dir, ConversionCache &cache,
+                             Profiler &profiler, ThreadPool &pool, bool link, bool in_place) noexcept
+    : _base_dir{base_dir},
+      _cache{cache},
+      _profiler{profiler},
+      _copy_stage{profiler.accumulated_stage("copy_textures")},
+      _link{link},
+      _in_place{in_place},
+      _tasks{pool} {}
+
+// hash of the source path, size and modification time
+[[nodiscard]] static uint64_t hash_source_file(const std::filesystem::path &source) {
+    uint64_t stat[]{std::filesystem::file_size(source),
+                    static_cast<uint64_t>(std::filesystem::last_write_time(source).time_since_epoch().count())};
+    return hash64(stat, sizeof(stat), hash64(source.generic_string()));
+}
+
+std::string TextureStager::stage(std::string_view file_name, std::string_view prefix) {
+    if (auto iter = _references.find(std::string{file_name}); iter != _references.end()) {
+        return iter->second;
+    }
+    std::filesystem::path source{file_name};
+    if (!source.is_absolute()) { source = _base_dir / source; }
+    source = std::filesystem::canonical(source);
+    auto [iter, first] = _sources.try_emplace(source.generic_string());
+    if (first) {
+        iter->second = _in_place ?
+                           source.generic_string() :
+                           luisa::format("lr_exported_textures/{}{}", prefix, source.filename().generic_string());
+        _copies.emplace(iter->second, std::move(source));
+        _pending_copies.emplace_back(iter->second);
+    }
+    _references.emplace(file_name, iter->second);
+    return iter->second;
+}
+
+void TextureStager::_copy(const std::filesystem::path &source, const std::string &copied_file) noexcept {
+    try {
+        _try_copy(source, copied_file);
+    } catch (const std::exception &e) {
+        // as before the copies were staged, a missing or unreadable image only loses that image
+        eprintln("Failed to copy image file {}: {}.", source.generic_string(), e.what());
+    }
+}
+
+void TextureStager::_try_copy(const std::filesystem::path &source, const std::string &copied_file) {
+    auto start = std::chrono::steady_clock::now();
+    auto input_hash = hash_source_file(source);
+    auto size = std::filesystem::file_size(source);
+    auto mtime = std::filesystem::last_write_time(source);
+    auto target = _base_dir / copied_file;
+    if (_cache.is_up_to_date(copied_file, input_hash)) {
+        println("Skipped copying up-to-date image file {}.", copied_file);
+    } else if (std::error_code ec;
+               !_cache.enabled() &&
+               std::filesystem::file_size(target, ec) == size && !ec &&
+               std::filesystem::last_write_time(target, ec) >= mtime && !ec &&
+               (_link || !std::filesystem::equivalent(source, target, ec))) {
+        // a copy newer than the source is kept, as std::filesystem::copy_options::update_existing
+        // does, unless it is a hard link from a previous run that should be a copy now
+        println("Skipped copying image file {} as the existing copy is newer.", copied_file);
+    } else {
+        std::filesystem::create_directories(target.parent_path());
+        auto method = copy_file_fast(source, target, _link);
+        println("Copied image file {} to {} ({}).", source.generic_string(), copied_file,
+                [method] {
+                    switch (method) {
+                        case FileCopyMethod::HardLink: return "hard link";
+                        case FileCopyMethod::Clone: return "clone";
+                        case FileCopyMethod::KernelCopy: return "kernel copy";
+                        case FileCopyMethod::StreamCopy: return "stream copy";
+                    }
+                    return "unknown";
+                }());
+        _profiler.add_bytes_written(size);
+        _profiler.accumulate(_copy_stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), size);
+    }
+    _cache.record(copied_file, input_hash);
+}
+
+void TextureStager::dispatch(const std::unordered_set<std::string> *used_files) {
+    auto used = [used_files](const std::string &file) noexcept {
+        return used_files == nullptr || used_files->contains(file);
+    };
+    for (auto &&file : _pending_copies) {
+        if (!used(file)) {
+            println("Skipped unreferenced image file {}.", file);
+            continue;
+        }
+        auto source = _copies.at(file);
+        _dispatched_count++;
+        std::error_code ec;
+        if (auto size = std::filesystem::file_size(source, ec); !ec) { _dispatched_bytes += size; }
+        if (!_in_place) {
+            _tasks.dispatch([this, source = std::move(source), file] { _copy(source, file); });
+        }
+    }
+    _pending_copies.clear();
+}
+
+void TextureStager::wait() { _tasks.wait(); }
+
+}// namespace luisa::render
@@ -0,0 +1,79 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <string_view>
+#include <filesystem>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "thread_pool.h"
+
+namespace luisa {
+class Profiler;
+}// namespace luisa
+
+namespace luisa::render {
+
+class ConversionCache;
+
+// Copies the image files referenced by a scene into lr_exported_textures. Every
+// source file is copied once, however many textures refer to it. The files
+// are staged while the textures are converted, and the copies dispatched to
+// the thread pool later, so that the files of textures pruned from the scene
+// are never copied. Scenes converted in process refer to the source files in place.
+class TextureStager {
+
+private:
+    std::filesystem::path _base_dir;
+    ConversionCache &_cache;
+    Profiler &_profiler;
+    size_t _copy_stage;
+    bool _link;
+    bool _in_place;
+    // referenced file name -> copied file relative to the scene directory
+    std::unordered_map<std::string, std::string> _references;
+    // canonical source path -> copied file relative to the scene directory
+    std::unordered_map<std::string, std::string> _sources;
+    // copied file -> canonical source path
+    std::unordered_map<std::string, std::filesystem::path> _copies;
+    // staged but not dispatched yet
+    std::vector<std::string> _pending_copies;
+    // number and total size of the dispatched source files
+    size_t _dispatched_count{0u};
+    uint64_t _dispatched_bytes{0u};
+    // last, so that the copies are finished before the rest is destroyed
+    TaskGroup _tasks;
+
+private:
+    void _try_copy(const std::filesystem::path &source, const std::string &copied_file);
+    // logs and skips the files that cannot be copied
+    void _copy(const std::filesystem::path &source, const std::string &copied_file) noexcept;
+
+public:
+    // copies are hard links to the sources if `link` is set and the file system allows it;
+    // nothing is copied if `in_place` is set
+    TextureStager(const std::filesystem::path &base_dir, ConversionCache &cache,
+                  Profiler &profiler, ThreadPool &pool, bool link, bool in_place = false) noexcept;
+    // Resolves `file_name` against the scene directory and stages its copy unless
+    // the same source is already staged. Returns the copy's path relative to the
+    // scene directory, named <prefix><file name> after the first reference, or the
+    // absolute source path in place.
+    // Throws if the source file does not exist.
+    [[nodiscard]] std::string stage(std::string_view file_name, std::string_view prefix);
+    // Starts the staged copies on the thread pool, skipping the files (as
+    // returned by stage()) not in `used_files` if given.
+    void dispatch(const std::unordered_set<std::string> *used_files = nullptr);
+    // number and total size of the distinct image files dispatched so far
+    [[nodiscard]] auto dispatched_count() const noexcept { return _dispatched_count; }
+    [[nodiscard]] auto dispatched_bytes() const noexcept { return _dispatched_bytes; }
+    // waits for the copies; those that failed have been reported and skipped
+    void wait();
+};
+
+}// namespace luisa::render
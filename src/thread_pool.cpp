@@ -0,0 +1,168 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <utility>
+#include <algorithm>
+
+#include "logging.h"
+#include "thread_pool.h"
+
+namespace luisa {
+
+static thread_local const ThreadPool *current_pool = nullptr;
+static thread_local size_t current_worker = 0u;
+
+ThreadPool::ThreadPool(size_t num_threads) noexcept {
+    if (num_threads == 0u) {
+        num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    _queues.reserve(num_threads);
+    for (auto i = 0u; i < num_threads; i++) {
+        _queues.emplace_back(std::make_unique<Queue>());
+    }
+    _threads.reserve(num_threads);
+    for (auto i = 0u; i < num_threads; i++) {
+        _threads.emplace_back([this, i] { _run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() noexcept {
+    {
+        std::scoped_lock lock{_mutex};
+        _should_stop = true;
+    }
+    _cv_task.notify_all();
+    for (auto &&t : _threads) { t.join(); }
+}
+
+bool ThreadPool::_try_pop(size_t worker, const TaskGroup *group, Task &task) noexcept {
+    // own queue first (LIFO for locality), then steal from the others (FIFO)
+    for (auto i = 0u; i < _queues.size(); i++) {
+        auto &q = *_queues[(worker + i) % _queues.size()];
+        std::scoped_lock lock{q.mutex};
+        auto take = [&](auto iter) noexcept {
+            task = std::move(iter->task);
+            q.tasks.erase(iter);
+        };
+        auto in_group = [group](const QueuedTask &t) noexcept { return group == nullptr || t.group == group; };
+        if (i == 0u) {
+            if (auto iter = std::find_if(q.tasks.rbegin(), q.tasks.rend(), in_group); iter != q.tasks.rend()) {
+                take(std::prev(iter.base()));
+                return true;
+            }
+        } else if (auto iter = std::find_if(q.tasks.begin(), q.tasks.end(), in_group); iter != q.tasks.end()) {
+            take(iter);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::_run_one(size_t worker, const TaskGroup *group) noexcept {
+    Task task;
+    if (!_try_pop(worker, group, task)) { return false; }
+    {
+        std::scoped_lock lock{_mutex};
+        _queued--;
+    }
+    try {
+        task();
+    } catch (const std::exception &e) {
+        // std::exit() would run the static destructors under the other workers
+        eprintln("Uncaught exception in worker thread: {}", e.what());
+        std::terminate();
+    }
+    auto idle = false;
+    {
+        std::scoped_lock lock{_mutex};
+        idle = (--_pending == 0u);
+    }
+    if (idle) { _cv_idle.notify_all(); }
+    return true;
+}
+
+void ThreadPool::_run(size_t worker) noexcept {
+    current_pool = this;
+    current_worker = worker;
+    for (;;) {
+        if (_run_one(worker)) { continue; }
+        std::unique_lock lock{_mutex};
+        _cv_task.wait(lock, [this] { return _should_stop || _queued != 0u; });
+        if (_should_stop && _queued == 0u) { return; }
+    }
+}
+
+void ThreadPool::dispatch(Task task) noexcept {
+    _dispatch(std::move(task), nullptr);
+}
+
+void ThreadPool::_dispatch(Task task, const TaskGroup *group) noexcept {
+    auto index = [this] {
+        if (current_pool == this) { return current_worker; }
+        std::scoped_lock lock{_mutex};
+        return _next_queue++ % _queues.size();
+    }();
+    {
+        // counted before it becomes visible, as a thief may finish it right away
+        std::scoped_lock lock{_mutex};
+        _queued++;
+        _pending++;
+        auto &q = *_queues[index];
+        std::scoped_lock queue_lock{q.mutex};
+        q.tasks.emplace_back(std::move(task), group);
+    }
+    _cv_task.notify_one();
+}
+
+void ThreadPool::synchronize() {
+    expect(current_pool != this, "ThreadPool::synchronize() called from a worker thread.");
+    std::unique_lock lock{_mutex};
+    _cv_idle.wait(lock, [this] { return _pending == 0u; });
+}
+
+TaskGroup::~TaskGroup() noexcept { _wait(); }
+
+void TaskGroup::dispatch(ThreadPool::Task task) noexcept {
+    {
+        std::scoped_lock lock{_mutex};
+        _pending++;
+    }
+    auto run = [this, task = std::move(task)] {
+        try {
+            task();
+        } catch (...) {
+            std::scoped_lock lock{_mutex};
+            if (!_error) { _error = std::current_exception(); }
+        }
+        // notify under the lock, as the group may be destroyed right after
+        std::scoped_lock lock{_mutex};
+        if (--_pending == 0u) { _cv.notify_all(); }
+    };
+    _pool._dispatch(std::move(run), this);
+}
+
+void TaskGroup::_wait() noexcept {
+    auto worker = current_pool == &_pool ? current_worker : 0u;
+    for (;;) {
+        {
+            std::scoped_lock lock{_mutex};
+            if (_pending == 0u) { return; }
+        }
+        // the group's tasks that are not queued any more are running elsewhere
+        if (!_pool._run_one(worker, this)) {
+            std::unique_lock lock{_mutex};
+            _cv.wait(lock, [this] { return _pending == 0u; });
+            return;
+        }
+    }
+}
+
+void TaskGroup::wait() {
+    _wait();
+    if (auto error = std::exchange(_error, nullptr)) {
+        std::rethrow_exception(error);
+    }
+}
+
+}// namespace luisa
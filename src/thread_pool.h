@@ -0,0 +1,104 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace luisa {
+
+class TaskGroup;
+
+// A small work-stealing thread pool. Every worker owns a task deque: it pops
+// its own tasks from the back and steals from the front of the others when
+// it runs dry. Tasks dispatched from outside the pool are distributed in a
+// round-robin manner; tasks dispatched from a worker go to its own deque.
+class ThreadPool {
+
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct QueuedTask {
+        Task task;
+        const TaskGroup *group;// null if dispatched directly
+    };
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<QueuedTask> tasks;
+    };
+
+private:
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _cv_task;
+    std::condition_variable _cv_idle;
+    size_t _queued{0u}; // dispatched but not yet picked up by a worker
+    size_t _pending{0u};// dispatched but not yet finished
+    size_t _next_queue{0u};
+    bool _should_stop{false};
+
+private:
+    friend class TaskGroup;
+    // pops any task if `group` is null, or only one of the group otherwise
+    [[nodiscard]] bool _try_pop(size_t worker, const TaskGroup *group, Task &task) noexcept;
+    // runs one queued task on the calling thread, returns false if there is none
+    bool _run_one(size_t worker, const TaskGroup *group = nullptr) noexcept;
+    void _run(size_t worker) noexcept;
+    void _dispatch(Task task, const TaskGroup *group) noexcept;
+
+public:
+    // 0 threads means std::thread::hardware_concurrency()
+    explicit ThreadPool(size_t num_threads = 0u) noexcept;
+    ~ThreadPool() noexcept;
+    ThreadPool(ThreadPool &&) noexcept = delete;
+    ThreadPool(const ThreadPool &) noexcept = delete;
+    ThreadPool &operator=(ThreadPool &&) noexcept = delete;
+    ThreadPool &operator=(const ThreadPool &) noexcept = delete;
+    [[nodiscard]] auto size() const noexcept { return _threads.size(); }
+    void dispatch(Task task) noexcept;
+    // blocks until all dispatched tasks are finished; throws if called from a worker,
+    // which would wait for itself
+    void synchronize();
+};
+
+// Tasks dispatched through a group can be waited for without waiting for the
+// rest of the pool, so that several conversions can share one pool. Waiting
+// threads run the queued tasks of the group meanwhile, and only those, so a
+// group may be waited for from a worker without the worker taking up unrelated
+// work, e.g. another conversion, on its stack. The first exception thrown by
+// the tasks of the group is rethrown from wait().
+class TaskGroup {
+
+private:
+    ThreadPool &_pool;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    size_t _pending{0u};
+    std::exception_ptr _error;
+
+private:
+    void _wait() noexcept;
+
+public:
+    explicit TaskGroup(ThreadPool &pool) noexcept : _pool{pool} {}
+    // waits for the remaining tasks, dropping their exceptions
+    ~TaskGroup() noexcept;
+    TaskGroup(TaskGroup &&) noexcept = delete;
+    TaskGroup(const TaskGroup &) noexcept = delete;
+    TaskGroup &operator=(TaskGroup &&) noexcept = delete;
+    TaskGroup &operator=(const TaskGroup &) noexcept = delete;
+    void dispatch(ThreadPool::Task task) noexcept;
+    void wait();
+};
+
+}// namespace luisa
@@ -0,0 +1,46 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#include <bit>
+#include <fstream>
+#include <algorithm>
+
+#include "hash.h"
+#include "logging.h"
+#include "transform_table.h"
+
+namespace luisa::render {
+
+std::optional<uint32_t> TransformTable::add(const float (&m)[4][4]) {
+    if (m[3][0] != 0.f || m[3][1] != 0.f || m[3][2] != 0.f || m[3][3] != 1.f) { return std::nullopt; }
+    Entry entry;
+    for (auto i = 0u; i < 3u; i++) {
+        std::copy_n(m[i], 4u, entry.data() + i * 4u);
+    }
+    auto &candidates = _lookup[hash64(entry.data(), sizeof(Entry))];
+    if (auto iter = std::find_if(candidates.cbegin(), candidates.cend(), [&](auto i) {
+            return _entries[i] == entry;
+        });
+        iter != candidates.cend()) {
+        return *iter;
+    }
+    auto index = static_cast<uint32_t>(_entries.size());
+    _entries.emplace_back(entry);
+    candidates.emplace_back(index);
+    return index;
+}
+
+void TransformTable::write(const std::filesystem::path &file) const {
+    static_assert(std::endian::native == std::endian::little, "Transform tables are little-endian.");
+    std::ofstream f{file, std::ios::binary};
+    expect(f.is_open(), "Failed to open transform table file {}.", file.generic_string());
+    f.write("LRXFORM\0", 8);
+    uint32_t header[]{1u, static_cast<uint32_t>(_entries.size())};
+    f.write(reinterpret_cast<const char *>(header), sizeof(header));
+    f.write(reinterpret_cast<const char *>(_entries.data()),
+            static_cast<std::streamsize>(_entries.size() * sizeof(Entry)));
+    expect(f.good(), "Failed to write transform table file {}.", file.generic_string());
+}
+
+}// namespace luisa::render
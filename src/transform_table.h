@@ -0,0 +1,44 @@
+//
+// Created by Mike on 2026/10/16.
+//
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+#include <unordered_map>
+
+namespace luisa::render {
+
+// Collects affine transforms into one contiguous binary table, which scene
+// nodes refer to by index instead of carrying 16 JSON numbers each.
+// Identical transforms share an entry.
+class TransformTable {
+
+public:
+    // the top 3 rows of a row-major affine matrix
+    using Entry = std::array<float, 12u>;
+
+private:
+    std::vector<Entry> _entries;
+    // hash -> indices of the entries with that hash
+    std::unordered_map<uint64_t, std::vector<uint32_t>> _lookup;
+
+public:
+    // Returns the index of the row-major matrix `m` in the table, or nullopt if
+    // it is projective and cannot be stored.
+    [[nodiscard]] std::optional<uint32_t> add(const float (&m)[4][4]);
+    [[nodiscard]] auto size() const noexcept { return _entries.size(); }
+    [[nodiscard]] auto empty() const noexcept { return _entries.empty(); }
+    // Writes the table as
+    //   char[8]  magic "LRXFORM\0"
+    //   uint32   version (1), entry count
+    //   per entry: float32[12], the top 3 rows of the row-major matrix
+    // All values are little-endian.
+    void write(const std::filesystem::path &file) const;
+};
+
+}// namespace luisa::render